@@ -16,11 +16,36 @@
 #   connect_set_rts, connect_rts_low,
 #   default_speed, max_move_mm, max_speed,
 #   default_lane_feed_mm, default_lane_retract_mm,
-#   supported_cmds
+#   supported_cmds, timesync_interval, latency_stamps,
+#   flow_control, flow_timeout, busy_retries, host_timeout, move_accel, move_jerk,
+#   feedforward, ff_interval, ff_lead,
+#   buffer_kp, buffer_ki, buffer_deadband, speed_kp, speed_ki, observer_bw
 #
 # Firmware surface (per KlipperCLI.cpp with LiteJSON):
-#   PING, STATUS, GET_SENSORS, MOVE, STOP, SELECT_LANE,
-#   SET_AUTO_FEED, GET_FILAMENT_INFO, SET_FILAMENT_INFO
+#   PING, STATUS, GET_SENSORS, MOVE, MOVE_POS, QUEUE_MOVE, GROUP_MOVE,
+#   EXTRUDER_VEL, STOP, SELECT_LANE,
+#   SET_AUTO_FEED, GET_FILAMENT_INFO, SET_FILAMENT_INFO,
+#   TIME_SYNC, COMM_STATS, FLASH_STATS, CRASHLOG, MOTOR_MODEL, AUTOTUNE,
+#   CAPTURE, CAPTURE_READ, CAPS, SET_CONFIG, OBSERVER
+#
+# Unsolicited events: STARTUP, READY, HOST_TIMEOUT, RECONNECT, MOVE_DONE,
+#   SEGMENT_DONE, GROUP_DONE, AUTOTUNE_DONE, CAPTURE_DONE
+#   MOVE_DONE ends every MOVE_POS with the final error, so macros can
+#   wait for it (BMCU_MOVE_POS WAIT_DONE=) instead of creeping up slowly.
+#   SEGMENT_DONE reports each QUEUE_MOVE segment and how many are left;
+#   a whole load sequence can be queued and awaited with BMCU_WAIT_QUEUE.
+#   GROUP_DONE ends a GROUP_MOVE (lanes = mask of lanes that completed).
+#   AUTOTUNE_DONE ends a relay autotune with the measured gains.
+#   CAPTURE_DONE ends a step-response capture; BMCU_CAPTURE then reads
+#   the samples (base64 chunks) into a CSV for bmcu_sysid.py.
+#   STARTUP is sent within milliseconds of reset with state "warming";
+#   READY follows once sensors are valid (lane data before it is not).
+#   The runtime configuration (SET_CONFIG, OBSERVER) is re-sent on every
+#   STARTUP, since a reset returns it to firmware defaults.
+#
+# RX overrun: a line that lost bytes in the firmware RX ring is answered
+#   BUSY with its id and resent (busy_retries).  A line that lost every
+#   byte gets no reply at all; callers waiting on it must time out (WAIT=).
 #
 # LiteJSON Firmware Limits:
 #   - MAX_KEYS = 8 (max key-value pairs per JSON object)
@@ -28,13 +53,114 @@
 #   - MAX_ARRAY_SIZE = 4 (max elements per array)
 #   - MAX_NESTING = 3 (max nesting depth)
 
+import base64
 import logging
 import json
+import struct
 import time
 
 import serial  # pyserial
 
 
+class ClockSync:
+    """
+    NTP-style estimate of the BMCU microsecond clock relative to the
+    host monotonic clock.
+
+    Each TIME_SYNC exchange gives four timestamps: host send (t0),
+    device line arrival (rx_us), device TX start (tx_us) and host
+    receive (t3).  The device clock is a 32-bit micros() counter, so
+    it is unwrapped here.  Offset and drift are fitted by least squares
+    over the lowest-RTT samples in a sliding window.
+    """
+    WINDOW = 16
+
+    def __init__(self):
+        self.samples = []          # (host_mid_s, dev_mid_s, rtt_s)
+        self._last_dev = None
+        self._wraps = 0
+        self.offset = None         # dev_s - host_s at host_ref
+        self.drift = 0.0           # dev rate error (s/s)
+        self.host_ref = 0.0
+        self.min_rtt = None
+
+    def unwrap(self, dev_us):
+        dev_us = int(dev_us) & 0xFFFFFFFF
+        if self._last_dev is not None and dev_us < self._last_dev \
+                and (self._last_dev - dev_us) > 0x80000000:
+            self._wraps += 1
+        self._last_dev = dev_us
+        return (self._wraps << 32) + dev_us
+
+    def add_sample(self, t0, t3, rx_us, tx_us):
+        rx = self.unwrap(rx_us) / 1e6
+        tx = rx + ((int(tx_us) - int(rx_us)) & 0xFFFFFFFF) / 1e6
+        rtt = (t3 - t0) - (tx - rx)
+        if rtt < 0:
+            return
+        self.samples.append(((t0 + t3) / 2.0, (rx + tx) / 2.0, rtt))
+        self.samples = self.samples[-self.WINDOW:]
+        self._fit()
+
+    def _fit(self):
+        self.min_rtt = min(x[2] for x in self.samples)
+        good = [x for x in self.samples if x[2] <= self.min_rtt * 1.5 + 0.0005]
+        self.host_ref = good[-1][0]
+        n = len(good)
+        mx = sum(x[0] - self.host_ref for x in good) / n
+        my = sum(x[1] - x[0] for x in good) / n
+        sxx = sum((x[0] - self.host_ref - mx) ** 2 for x in good)
+        if n >= 2 and sxx > 1.0:
+            sxy = sum((x[0] - self.host_ref - mx) * (x[1] - x[0] - my) for x in good)
+            self.drift = sxy / sxx
+        self.offset = my - self.drift * mx
+
+    def host_to_device(self, host_s):
+        if self.offset is None:
+            return None
+        return host_s + self.offset + self.drift * (host_s - self.host_ref)
+
+    def device_to_host(self, dev_s):
+        if self.offset is None:
+            return None
+        return (dev_s - self.offset + self.drift * self.host_ref) / (1.0 + self.drift)
+
+
+class LatencyStats:
+    """Rolling per-command latency samples (seconds) with percentiles."""
+    KEEP = 256
+    FIELDS = ('rtt', 'queue', 'exec', 'wire')
+
+    def __init__(self):
+        self.by_cmd = {}
+
+    def add(self, cmd, **vals):
+        entry = self.by_cmd.setdefault(cmd, {f: [] for f in self.FIELDS})
+        for k, v in vals.items():
+            if v is None or k not in entry:
+                continue
+            entry[k].append(v)
+            if len(entry[k]) > self.KEEP:
+                del entry[k][0]
+
+    @staticmethod
+    def _pct(vals, p):
+        if not vals:
+            return None
+        s = sorted(vals)
+        return s[min(len(s) - 1, int(round(p / 100.0 * (len(s) - 1))))]
+
+    def summary(self):
+        out = {}
+        for cmd, entry in self.by_cmd.items():
+            out[cmd] = {f: (len(v), self._pct(v, 50), self._pct(v, 99))
+                        for f, v in entry.items() if v}
+        return out
+
+    def reset(self):
+        self.by_cmd = {}
+
+
 class BMCU:
     def __init__(self, config):
         self.printer = config.get_printer()
@@ -82,6 +208,48 @@ class BMCU:
         self.default_lane_feed_mm = config.getfloat('default_lane_feed_mm', 60.0)
         self.default_lane_retract_mm = config.getfloat('default_lane_retract_mm', 60.0)
 
+        # Time sync / latency stamps (0 disables periodic sync)
+        self.timesync_interval = config.getfloat('timesync_interval', 60.0)
+        self.latency_stamps = config.getboolean('latency_stamps', False)
+
+        # Credit-based flow control against the firmware RX ring
+        self.flow_control = config.getboolean('flow_control', True)
+        self.flow_timeout = config.getfloat('flow_timeout', 0.5)
+        self.busy_retries = config.getint('busy_retries', 2)
+
+        # Firmware stops velocity moves if it hears nothing for this long
+        # (0 disables).  A heartbeat PING keeps the link alive when idle.
+        self.host_timeout = config.getfloat('host_timeout', 3.0, minval=0.)
+
+        # MOVE velocity shaping in the firmware (mm/s^2, mm/s^3).
+        # move_accel 0 disables it; move_jerk 0 gives a trapezoid.
+        self.move_accel = config.getfloat('move_accel', 400.0, minval=0.)
+        self.move_jerk = config.getfloat('move_jerk', 0.0, minval=0.)
+
+        # Extruder feedforward: stream the extruder velocity (looked up
+        # ff_lead seconds ahead in the motion queue) so AutoFeed follows
+        # extrusion instead of waiting for the buffer to move.
+        self.feedforward = config.getboolean('feedforward', False)
+        self.ff_interval = config.getfloat('ff_interval', 0.05, minval=0.02)
+        self.ff_lead = config.getfloat('ff_lead', 0.1, minval=0.)
+
+        # AutoFeed cascade gains: buffer offset (V) -> lane speed (mm/s),
+        # then lane speed -> PWM.  Only gains set here are sent on connect,
+        # so the others keep the firmware's (possibly BMCU_AUTOTUNE SAVE=1)
+        # values.  Tunable at runtime with BMCU_SET_GAINS.
+        gain_keys = (("buf_kp", 'buffer_kp'), ("buf_ki", 'buffer_ki'),
+                     ("buf_db", 'buffer_deadband'), ("spd_kp", 'speed_kp'),
+                     ("spd_ki", 'speed_ki'))
+        self.gains = {}
+        for key, option in gain_keys:
+            val = config.getfloat(option, None, minval=0.)
+            if val is not None:
+                self.gains[key] = val
+
+        # Encoder velocity observer bandwidth (Hz, 0 = raw finite
+        # difference); the firmware default is used when unset.
+        self.observer_bw = config.getfloat('observer_bw', None, minval=0., maxval=100.)
+
         # Optional allowlist of commands
         supported = config.get('supported_cmds', '').strip()
         if supported:
@@ -102,6 +270,34 @@ class BMCU:
         self.last_rx = None
         self.last_rx_by_id = {}
 
+        # In-flight packets: id -> (cmd, host send time, raw msg, retries)
+        self._inflight = {}
+        # Flow control: last advertised RX free bytes, and (id, nbytes)
+        # of packets sent since, in send order
+        self._rx_credit = None
+        self._tx_log = []
+        self._in_read = False
+        self.busy_count = 0
+        self._last_tx = 0.0
+        self.host_timeouts = 0
+
+        # Last MOVE_DONE / SEGMENT_DONE per lane, and a counter to wait on
+        self.move_results = {}
+        self.segment_results = {}
+        self._move_done_seq = 0
+        self._queue_sent_seq = {}
+        self.group_result = {}
+        self.autotune_result = {}
+        self.capture_result = {}
+        self._ff_last_v = 0.0
+
+        # Latest PING telemetry (link health summary)
+        self.telemetry = {}
+        self.clock = ClockSync()
+        self.latency = LatencyStats()
+        self._last_timesync = 0.0
+        self._latency_log_time = 0.0
+
         # Have we already kicked a STATUS after STARTUP?
         self._did_startup_status = False
 
@@ -134,6 +330,12 @@ class BMCU:
         now = self.reactor.NOW
         self._read_timer = self.reactor.register_timer(self._handle_read, now + self.read_interval)
         self._poll_timer = self.reactor.register_timer(self._handle_poll, now + self.poll_interval)
+        if self.host_timeout > 0:
+            self._heartbeat_timer = self.reactor.register_timer(
+                self._handle_heartbeat, now + self.host_timeout / 3.0)
+        if self.feedforward:
+            self._ff_timer = self.reactor.register_timer(
+                self._handle_feedforward, now + self.ff_interval)
 
         if self.debug:
             logging.info("BMCU: initialized (deferred connect) serial=%s baud=%d",
@@ -152,6 +354,10 @@ class BMCU:
         gc.register_command("BMCU_SELECT_LANE", self.cmd_BMCU_SELECT_LANE)
         gc.register_command("BMCU_SET_AUTO_FEED", self.cmd_BMCU_SET_AUTO_FEED)
         gc.register_command("BMCU_MOVE", self.cmd_BMCU_MOVE)
+        gc.register_command("BMCU_MOVE_POS", self.cmd_BMCU_MOVE_POS)
+        gc.register_command("BMCU_QUEUE_MOVE", self.cmd_BMCU_QUEUE_MOVE)
+        gc.register_command("BMCU_WAIT_QUEUE", self.cmd_BMCU_WAIT_QUEUE)
+        gc.register_command("BMCU_GROUP_MOVE", self.cmd_BMCU_GROUP_MOVE)
         gc.register_command("BMCU_FEED", self.cmd_BMCU_FEED)
         gc.register_command("BMCU_SELECTOR", self.cmd_BMCU_SELECTOR)
         gc.register_command("BMCU_SPOOL", self.cmd_BMCU_SPOOL)
@@ -160,6 +366,17 @@ class BMCU:
         gc.register_command("BMCU_CALL", self.cmd_BMCU_CALL)
         gc.register_command("BMCU_LANE_FEED", self.cmd_BMCU_LANE_FEED)
         gc.register_command("BMCU_LANE_RETRACT", self.cmd_BMCU_LANE_RETRACT)
+        gc.register_command("BMCU_TIME_SYNC", self.cmd_BMCU_TIME_SYNC)
+        gc.register_command("BMCU_LATENCY", self.cmd_BMCU_LATENCY)
+        gc.register_command("BMCU_COMM_STATS", self.cmd_BMCU_COMM_STATS)
+        gc.register_command("BMCU_FLASH_STATS", self.cmd_BMCU_FLASH_STATS)
+        gc.register_command("BMCU_CRASHLOG", self.cmd_BMCU_CRASHLOG)
+        gc.register_command("BMCU_MOTOR_MODEL", self.cmd_BMCU_MOTOR_MODEL)
+        gc.register_command("BMCU_AUTOTUNE", self.cmd_BMCU_AUTOTUNE)
+        gc.register_command("BMCU_CAPTURE", self.cmd_BMCU_CAPTURE)
+        gc.register_command("BMCU_SET_HOST_TIMEOUT", self.cmd_BMCU_SET_HOST_TIMEOUT)
+        gc.register_command("BMCU_SET_GAINS", self.cmd_BMCU_SET_GAINS)
+        gc.register_command("BMCU_OBSERVER", self.cmd_BMCU_OBSERVER)
 
     # -----------------------------
     # Timers
@@ -175,14 +392,67 @@ class BMCU:
         if self.tx_rx_mode == 'halfduplex':
             self._pump_rx(0.05)
 
+        if self.timesync_interval > 0 and \
+                (eventtime - self._last_timesync) >= self.timesync_interval:
+            self._time_sync(bursts=1)
+
+        if self.debug and self.latency_stamps and \
+                (eventtime - self._latency_log_time) >= 60.0:
+            self._latency_log_time = eventtime
+            for line in self._latency_lines():
+                logging.info("BMCU latency: %s", line)
+
         return eventtime + self.poll_interval
 
+    def _handle_heartbeat(self, eventtime):
+        # Any TX resets the firmware watchdog, so only ping when quiet
+        if self.host_timeout <= 0:
+            return eventtime + 1.0
+        period = self.host_timeout / 3.0
+        if self.is_connected and (time.monotonic() - self._last_tx) >= period:
+            self._send_pkt("PING", {}, note="heartbeat")
+        return eventtime + period
+
+    def _extruder_velocity(self, eventtime):
+        # Planned extruder velocity at print_time + ff_lead (mm/s, signed)
+        try:
+            mr = self.printer.lookup_object('motion_report', None)
+            toolhead = self.printer.lookup_object('toolhead')
+            dtq = mr.trapqs.get(toolhead.get_extruder().get_name()) if mr else None
+            if dtq is None:
+                return 0.0
+            mcu = self.printer.lookup_object('mcu')
+            t = mcu.estimated_print_time(eventtime) + self.ff_lead
+            pos, vel = dtq.get_trapq_position(t)
+            if pos is None or not vel:
+                return 0.0
+            prev, _ = dtq.get_trapq_position(t - 0.005)
+            if prev is not None and pos[0] < prev[0]:
+                return -vel
+            return vel
+        except Exception:
+            return 0.0
+
+    def _handle_feedforward(self, eventtime):
+        # Stream while the extruder moves; once it stops, send a single 0
+        # and let the firmware time out to the pressure window
+        if not self.is_connected:
+            return eventtime + 0.5
+        v = round(self._clamp(self._extruder_velocity(eventtime),
+                              -self.max_speed, self.max_speed), 1)
+        if v != 0.0 or self._ff_last_v != 0.0:
+            self._send_pkt("EXTRUDER_VEL", {"v": v}, note="ff")
+            self._ff_last_v = v
+        return eventtime + self.ff_interval
+
     def _handle_read(self, eventtime):
         if not self.is_connected or self.ser is None:
             return eventtime + max(self.read_interval, 0.1)
+        self._in_read = True
         try:
             data = self.ser.read(4096)
             if data:
+                rx_time = time.monotonic()
                 if self.debug:
                     logging.info("BMCU RX chunk: len=%d hex=%s...",
                                  len(data), data[:16].hex())
@@ -199,7 +469,7 @@ class BMCU:
                     self._buf = self._buf[idx+1:]
                     line = line.strip()
                     if line:
-                        self._process_line(line)
+                        self._process_line(line, rx_time)
 
                 if len(self._buf) > 4096:
                     logging.error("BMCU: Buffer overflow (>4k), clearing")
@@ -207,6 +477,8 @@ class BMCU:
         except Exception as e:
             logging.error("BMCU: read error: %s", e)
             self._disconnect()
+        finally:
+            self._in_read = False
         return eventtime + self.read_interval
 
     # -----------------------------
@@ -291,9 +563,27 @@ class BMCU:
             pass
         self.is_connected = True
         self._did_startup_status = False
+        self._inflight = {}
+        self._rx_credit = None
+        self._tx_log = []
+        self.clock = ClockSync()
+        self._send_config()
+        if self.timesync_interval > 0 or self.latency_stamps:
+            self._time_sync(bursts=4)
         if self.debug:
             logging.info("BMCU: connected on %s @ %d", self.serial_port, self.baud)
 
+    def _send_config(self):
+        # Runtime settings the firmware does not persist; sent on connect
+        # and again whenever it reports STARTUP
+        cfg = {"host_timeout_ms": int(self.host_timeout * 1000),
+               "move_accel": float(self.move_accel),
+               "move_jerk": float(self.move_jerk)}
+        cfg.update(self.gains)
+        self._send_pkt("SET_CONFIG", cfg, note="host_timeout")
+        if self.observer_bw is not None:
+            self._send_pkt("OBSERVER", {"bw_hz": float(self.observer_bw)}, note="observer")
+
     def _disconnect(self):
         self.is_connected = False
         if self.ser is not None:
@@ -318,11 +608,14 @@ class BMCU:
         except Exception:
             old_to = None
         t_end = time.time() + max(0.0, float(budget_s))
+        prev_in_read = self._in_read
+        self._in_read = True
         try:
             while time.time() < t_end:
                 data = self.ser.read(4096)
                 if not data:
                     break
+                rx_time = time.monotonic()
                 self._buf += data.decode('utf-8', errors='ignore')
                 while '\n' in self._buf or '\r' in self._buf:
                     idx_n = self._buf.find('\n')
@@ -335,10 +628,11 @@ class BMCU:
                     self._buf = self._buf[idx+1:]
                     line = line.strip()
                     if line:
-                        self._process_line(line)
+                        self._process_line(line, rx_time)
         except Exception:
             pass
         finally:
+            self._in_read = prev_in_read
             try:
                 if old_to is not None:
                     self.ser.timeout = old_to
@@ -363,14 +657,135 @@ class BMCU:
             msg = json.dumps(pkt) + self.line_ending
             if self.debug:
                 logging.info("BMCU TX(%s): %s", note or "pkt", msg.strip())
-            self.ser.write(msg.encode('utf-8'))
+            self._write_msg(pkt_id, cmd, msg, 0)
             return True, pkt_id
         except Exception as e:
             logging.error("BMCU: send error: %s", e)
             self._disconnect()
             return False, None
 
-    def _process_line(self, line):
+    def _write_msg(self, pkt_id, cmd, msg, retries):
+        data = msg.encode('utf-8')
+        self._wait_for_credit(len(data))
+        self._inflight[pkt_id] = (cmd, time.monotonic(), msg, retries)
+        if len(self._inflight) > 64:
+            for k in list(self._inflight.keys())[:16]:
+                self._inflight.pop(k, None)
+        self._tx_log.append((pkt_id, len(data)))
+        if len(self._tx_log) > 64:
+            del self._tx_log[:16]
+        if self._rx_credit is not None:
+            self._rx_credit -= len(data)
+        self.ser.write(data)
+        self._last_tx = time.monotonic()
+
+    def _wait_for_credit(self, nbytes):
+        # Block briefly until the firmware has advertised enough free RX
+        # space.  Never pauses from inside the read path (re-entrancy).
+        if not self.flow_control or self._rx_credit is None or self._in_read:
+            return
+        end = self.reactor.monotonic() + self.flow_timeout
+        while self._rx_credit < nbytes and self.reactor.monotonic() < end:
+            if self.tx_rx_mode == 'halfduplex':
+                self._pump_rx(0.005)
+            self.reactor.pause(self.reactor.monotonic() + 0.005)
+        if self._rx_credit < nbytes:
+            # Stale credit (lost reply); fall back to optimistic sending
+            self._rx_credit = None
+
+    def _update_credit(self, rx_id, rx_free):
+        # rx_free was measured when the reply to rx_id was sent; anything we
+        # sent after rx_id may not have been counted yet
+        for i, (pid, _) in enumerate(self._tx_log):
+            if pid == rx_id:
+                del self._tx_log[:i + 1]
+                break
+        self._rx_credit = int(rx_free) - sum(n for _, n in self._tx_log)
+
+    def _resend(self, pkt_id, cmd, msg, retries):
+        if not self.is_connected or self.ser is None:
+            return
+        try:
+            self._write_msg(pkt_id, cmd, msg, retries)
+        except Exception as e:
+            logging.error("BMCU: resend error: %s", e)
+            self._disconnect()
+
+    def _time_sync(self, bursts=1):
+        # Several back-to-back exchanges; the fit keeps the lowest-RTT ones
+        self._last_timesync = self.reactor.monotonic()
+        for _ in range(max(1, bursts)):
+            host_ms = int(time.monotonic() * 1000) % 1000000000
+            ok, _ = self._send_pkt(
+                "TIME_SYNC",
+                {"host_ms": host_ms, "stamps": bool(self.latency_stamps)},
+                note="timesync")
+            if not ok:
+                return
+            self._pump_rx(0.05)
+
+    def _note_reply(self, pkt, rx_time):
+        try:
+            rx_id = int(pkt["id"])
+        except Exception:
+            return
+        if "rx_free" in pkt:
+            try:
+                self._update_credit(rx_id, pkt["rx_free"])
+            except Exception:
+                pass
+        sent = self._inflight.pop(rx_id, None)
+        if sent is None:
+            return
+        cmd, t0, msg, retries = sent
+        t3 = rx_time if rx_time is not None else time.monotonic()
+
+        if pkt.get("ok") is False and pkt.get("code") == "BUSY":
+            # Firmware dropped the line on RX overrun; resend once drained
+            self.busy_count += 1
+            if retries < self.busy_retries:
+                self.reactor.register_callback(
+                    lambda e: self._resend(rx_id, cmd, msg, retries + 1))
+            return
+
+        if pkt.get("cmd") == "TIME_SYNC" and "rx_us" in pkt and "tx_us" in pkt:
+            self.clock.add_sample(t0, t3, pkt["rx_us"], pkt["tx_us"])
+
+        ts = pkt.get("ts")
+        if isinstance(ts, list) and len(ts) == 3:
+            rx_us, disp_us, tx_us = [int(v) & 0xFFFFFFFF for v in ts]
+            queue = ((disp_us - rx_us) & 0xFFFFFFFF) / 1e6
+            exe = ((tx_us - disp_us) & 0xFFFFFFFF) / 1e6
+            rtt = t3 - t0
+            self.latency.add(cmd, rtt=rtt, queue=queue, exec=exe,
+                             wire=max(0.0, rtt - queue - exe))
+        else:
+            self.latency.add(cmd, rtt=t3 - t0)
+
+    def _note_telemetry(self, tel):
+        # Flag growth in link health counters between polls, so lost
+        # commands can be attributed to line noise vs. MCU backlog
+        prev = self.telemetry
+        for key, what in (("line_err", "UART line errors (noise/framing/overrun)"),
+                          ("drop_bytes", "RX ring drops (MCU falling behind)"),
+                          ("parse_err", "unparseable frames")):
+            if key in tel and key in prev and tel[key] > prev[key]:
+                logging.warning("BMCU: %s increased %d -> %d", what, prev[key], tel[key])
+        self.telemetry = dict(tel)
+
+    def _latency_lines(self):
+        lines = []
+        for cmd, fields in sorted(self.latency.summary().items()):
+            parts = []
+            for f in LatencyStats.FIELDS:
+                if f in fields:
+                    n, p50, p99 = fields[f]
+                    parts.append("%s p50=%.2fms p99=%.2fms" % (f, p50 * 1e3, p99 * 1e3))
+            lines.append("%s (n=%d): %s" % (cmd, fields['rtt'][0] if 'rtt' in fields else 0,
+                                           ", ".join(parts)))
+        return lines
+
+    def _process_line(self, line, rx_time=None):
         # Junk-tolerant: handle 'UN{...}' and similar noise
         if not isinstance(line, str):
             line = str(line)
@@ -403,6 +818,23 @@ class BMCU:
 
             # Special: firmware startup event
             if isinstance(pkt, dict) and pkt.get("event") == "STARTUP":
+                if pkt.get("reset", "power_on") != "power_on":
+                    logging.warning("BMCU: firmware restarted (reset=%s, warm=%s, warm_restarts=%s)",
+                                    pkt.get("reset"), pkt.get("warm"), pkt.get("warm_restarts"))
+                if pkt.get("crashlog"):
+                    logging.warning("BMCU: firmware holds a crash report, run BMCU_CRASHLOG")
+                # The reset dropped everything set since connect, and micros()
+                # restarted: drop clock samples and credit from before it, and
+                # re-sync (which also re-sends the stamps flag) on the next poll
+                self.clock = ClockSync()
+                self._rx_credit = None
+                self._tx_log = []
+                self._last_timesync = 0.0
+                self._did_startup_status = False
+                self._send_config()
+                if pkt.get("state") == "warming":
+                    # Lane readings are not valid yet; STATUS follows READY
+                    return
                 if self.debug:
                     logging.info("BMCU: got STARTUP event, requesting STATUS once")
                 if not self._did_startup_status:
@@ -410,7 +842,85 @@ class BMCU:
                     self._send_pkt("STATUS", {}, note="startup_status")
                 return
 
+            if isinstance(pkt, dict) and pkt.get("event") == "READY":
+                logging.info("BMCU: firmware ready after %sms (first reply at %sms)",
+                             pkt.get("ready_ms"), pkt.get("first_reply_ms"))
+                if not self._did_startup_status:
+                    self._did_startup_status = True
+                    self._send_pkt("STATUS", {}, note="startup_status")
+                return
+
+            if isinstance(pkt, dict) and pkt.get("event") == "HOST_TIMEOUT":
+                self.host_timeouts += 1
+                logging.warning("BMCU: firmware host timeout after %sms, stopped lanes mask=%s",
+                                pkt.get("timeout_ms"), pkt.get("stopped"))
+                return
+
+            if isinstance(pkt, dict) and pkt.get("event") == "MOVE_DONE":
+                self._move_done_seq += 1
+                lane = pkt.get("lane")
+                self.move_results[str(lane)] = {
+                    "error_um": pkt.get("error_um"),
+                    "settled": bool(pkt.get("settled")),
+                    "seq": self._move_done_seq,
+                }
+                if not pkt.get("settled"):
+                    logging.warning("BMCU: lane %s position move did not settle (error %sum)",
+                                    lane, pkt.get("error_um"))
+                elif self.debug:
+                    logging.info("BMCU: lane %s position move done, error %sum",
+                                 lane, pkt.get("error_um"))
+                return
+
+            if isinstance(pkt, dict) and pkt.get("event") == "SEGMENT_DONE":
+                self._move_done_seq += 1
+                self.segment_results[str(pkt.get("lane"))] = {
+                    "tag": pkt.get("tag"),
+                    "left": pkt.get("left"),
+                    "seq": self._move_done_seq,
+                }
+                if self.debug:
+                    logging.info("BMCU: lane %s segment %s done, %s left",
+                                 pkt.get("lane"), pkt.get("tag"), pkt.get("left"))
+                return
+
+            if isinstance(pkt, dict) and pkt.get("event") == "GROUP_DONE":
+                self._move_done_seq += 1
+                self.group_result = {
+                    "tag": pkt.get("tag"),
+                    "lanes": pkt.get("lanes"),
+                    "elapsed_ms": pkt.get("elapsed_ms"),
+                    "seq": self._move_done_seq,
+                }
+                if self.debug:
+                    logging.info("BMCU: group %s done, lanes=%s in %sms",
+                                 pkt.get("tag"), pkt.get("lanes"), pkt.get("elapsed_ms"))
+                return
+
+            if isinstance(pkt, dict) and pkt.get("event") == "AUTOTUNE_DONE":
+                self._move_done_seq += 1
+                self.autotune_result = dict(pkt, seq=self._move_done_seq)
+                self.autotune_result.pop("event", None)
+                logging.info("BMCU: lane %s %s autotune %s (kp=%.3f ki=%.3f)",
+                             pkt.get("lane"), pkt.get("loop"), pkt.get("status"),
+                             (pkt.get("kp_x1000") or 0) / 1000.0,
+                             (pkt.get("ki_x1000") or 0) / 1000.0)
+                return
+
+            if isinstance(pkt, dict) and pkt.get("event") == "CAPTURE_DONE":
+                self._move_done_seq += 1
+                self.capture_result = dict(pkt, seq=self._move_done_seq)
+                self.capture_result.pop("event", None)
+                return
+
+            if isinstance(pkt, dict) and pkt.get("event") == "RECONNECT":
+                logging.info("BMCU: firmware saw host again after %sms offline, resyncing",
+                             pkt.get("offline_ms"))
+                self._send_pkt("STATUS", {}, note="reconnect_status")
+                return
+
             if isinstance(pkt, dict) and "id" in pkt:
+                self._note_reply(pkt, rx_time)
                 try:
                     rx_id = int(pkt["id"])
                     self.last_rx_by_id[rx_id] = pkt
@@ -423,6 +933,9 @@ class BMCU:
             if isinstance(pkt, dict) and "lanes" in pkt:
                 self.lanes = pkt.get("lanes")
 
+            if isinstance(pkt, dict) and isinstance(pkt.get("telemetry"), dict):
+                self._note_telemetry(pkt["telemetry"])
+
         except json.JSONDecodeError:
             if self.debug:
                 logging.warning("BMCU: non-json line: %r", raw_line[:240])
@@ -466,7 +979,14 @@ class BMCU:
         """
         lanes = self.lanes if isinstance(self.lanes, list) else []
         return {
-            'lanes': lanes
+            'lanes': lanes,
+            'comm': self.telemetry,
+            'host_timeouts': self.host_timeouts,
+            'move_results': self.move_results,
+            'segment_results': self.segment_results,
+            'group_result': self.group_result,
+            'autotune_result': self.autotune_result,
+            'capture_result': self.capture_result,
         }
 
     # Preserve the old _get_status for backward compatibility; delegate to get_status.
@@ -486,6 +1006,47 @@ class BMCU:
             gcmd.respond_info("BMCU_CAPS: all commands allowed (no allowlist).")
         else:
             gcmd.respond_info("Allowed commands: " + ", ".join(sorted(self.supported_cmds)))
+        ok, pkt_id = self._send_pkt("CAPS", {}, note="caps")
+        if ok:
+            self._wait_for_reply(gcmd, pkt_id, gcmd.get_float("WAIT", 0.5))
+
+    def cmd_BMCU_SET_HOST_TIMEOUT(self, gcmd):
+        timeout = gcmd.get_float("TIMEOUT", self.host_timeout, minval=0.)
+        if timeout > 0 and self.host_timeout <= 0:
+            raise gcmd.error("BMCU: heartbeat disabled in config; set host_timeout first")
+        self.host_timeout = timeout
+        ok, pkt_id = self._send_pkt("SET_CONFIG", {"host_timeout_ms": int(timeout * 1000)},
+                                    note="host_timeout")
+        if not ok:
+            raise gcmd.error("BMCU: not connected")
+        self._wait_for_reply(gcmd, pkt_id, gcmd.get_float("WAIT", 0.5))
+
+    def cmd_BMCU_SET_GAINS(self, gcmd):
+        # Retune the AutoFeed cascade; omitted gains keep their value
+        names = {"BUFFER_KP": "buf_kp", "BUFFER_KI": "buf_ki",
+                 "BUFFER_DEADBAND": "buf_db", "SPEED_KP": "spd_kp", "SPEED_KI": "spd_ki"}
+        for param, key in names.items():
+            val = gcmd.get_float(param, self.gains.get(key), minval=0.)
+            if val is not None:
+                self.gains[key] = val
+        ok, pkt_id = self._send_pkt("SET_CONFIG", dict(self.gains), note="gains")
+        gcmd.respond_info("BMCU gains: " + ", ".join(
+            f"{k}={v:g}" for k, v in self.gains.items()))
+        if ok:
+            self._wait_for_reply(gcmd, pkt_id, gcmd.get_float("WAIT", 0.5))
+
+    def cmd_BMCU_OBSERVER(self, gcmd):
+        # Encoder velocity observer; BW= sets the bandwidth in Hz (0 = raw)
+        args = {}
+        bw = gcmd.get_float("BW", None, minval=0., maxval=100.)
+        if bw is not None:
+            self.observer_bw = bw
+            args["bw_hz"] = bw
+        reply = self._request(gcmd, "OBSERVER", args)
+        speeds = ", ".join(f"{v:.1f}" for v in reply.get("speed", []))
+        lags = ", ".join(str(v) for v in reply.get("lag_um", []))
+        gcmd.respond_info(f"BMCU observer: {reply.get('bw_hz', 0):g}Hz, "
+                          f"speed mm/s [{speeds}], lag um [{lags}]")
 
     def cmd_BMCU_PING(self, gcmd):
         wait_s = gcmd.get_float("WAIT", 0.0)
@@ -535,15 +1096,157 @@ class BMCU:
         wait_s = gcmd.get_float("WAIT", 0.0)
         dist = self._clamp(dist, -self.max_move_mm, self.max_move_mm)
         speed = self._clamp(speed, -self.max_speed, self.max_speed)
-        ok, pkt_id = self._send_pkt(
-            "MOVE",
-            {"axis": str(axis), "dist_mm": float(dist), "speed": float(speed)},
-            note="move"
-        )
+        args = {"axis": str(axis), "dist_mm": float(dist), "speed": float(speed)}
+        # Per-move overrides of move_accel / move_jerk
+        accel = gcmd.get_float("ACCEL", None, minval=0.)
+        jerk = gcmd.get_float("JERK", None, minval=0.)
+        if accel is not None:
+            args["accel"] = accel
+        if jerk is not None:
+            args["jerk"] = jerk
+        ok, pkt_id = self._send_pkt("MOVE", args, note="move")
         gcmd.respond_info(f"MOVE axis={axis} dist={dist} speed={speed}")
         if ok:
             self._wait_for_reply(gcmd, pkt_id, wait_s)
 
+    def cmd_BMCU_MOVE_POS(self, gcmd):
+        # Closed-loop move that lands on DIST within TOL (mm); WAIT_DONE
+        # blocks until the firmware reports MOVE_DONE (seconds, 0 = no wait)
+        axis = gcmd.get("AXIS", "0")
+        dist = gcmd.get_float("DIST", 0.0)
+        speed = gcmd.get_float("SPEED", self.default_speed, above=0.)
+        wait_done = gcmd.get_float("WAIT_DONE", 0.0, minval=0.)
+        dist = self._clamp(dist, -self.max_move_mm, self.max_move_mm)
+        speed = self._clamp(speed, 0.0, self.max_speed)
+        args = {"axis": str(axis), "dist_mm": float(dist), "speed": float(speed)}
+        accel = gcmd.get_float("ACCEL", None, minval=0.)
+        jerk = gcmd.get_float("JERK", None, minval=0.)
+        tol = gcmd.get_float("TOL", None, above=0.)
+        if accel is not None:
+            args["accel"] = accel
+        if jerk is not None:
+            args["jerk"] = jerk
+        if tol is not None:
+            args["tol_mm"] = tol
+        start_seq = self._move_done_seq
+        ok, pkt_id = self._send_pkt("MOVE_POS", args, note="move_pos")
+        gcmd.respond_info(f"MOVE_POS axis={axis} dist={dist} speed={speed}")
+        if not ok or wait_done <= 0:
+            return
+        end = self.reactor.monotonic() + wait_done
+        while self.reactor.monotonic() < end:
+            self.reactor.pause(self.reactor.monotonic() + 0.05)
+            for lane, res in self.move_results.items():
+                if res["seq"] <= start_seq or (str(axis).isdigit() and lane != str(axis)):
+                    continue
+                if not res["settled"]:
+                    raise gcmd.error(f"BMCU: lane {lane} did not settle (error {res['error_um']}um)")
+                gcmd.respond_info(f"MOVE_POS lane={lane} done, error {res['error_um']}um")
+                return
+        raise gcmd.error(f"BMCU: no MOVE_DONE within {wait_done:.1f}s")
+
+    def cmd_BMCU_QUEUE_MOVE(self, gcmd):
+        # Append a segment to the lane's firmware move queue.  POS=1 makes
+        # it a closed-loop segment; DELAY (ms) holds its start.
+        lane = gcmd.get_int("LANE", 0, minval=0, maxval=3)
+        dist = gcmd.get_float("DIST")
+        speed = gcmd.get_float("SPEED", self.default_speed, above=0.)
+        dist = self._clamp(dist, -self.max_move_mm, self.max_move_mm)
+        speed = self._clamp(speed, 0.0, self.max_speed)
+        if dist == 0:
+            raise gcmd.error("BMCU_QUEUE_MOVE: DIST must be non-zero")
+        args = {"axis": str(lane), "dist_mm": float(dist), "speed": float(speed)}
+        accel = gcmd.get_float("ACCEL", None, minval=0.)
+        tol = gcmd.get_float("TOL", None, above=0.)
+        delay = gcmd.get_int("DELAY", 0, minval=0)
+        if accel is not None:
+            args["accel"] = accel
+        if gcmd.get_int("POS", 0):
+            args["pos"] = True
+            if tol is not None:
+                args["tol_mm"] = tol
+        if delay:
+            args["delay_ms"] = delay
+        args["tag"] = gcmd.get_int("TAG", 0, minval=0, maxval=65535)
+        if str(lane) not in self._queue_sent_seq:
+            self._queue_sent_seq[str(lane)] = self._move_done_seq
+        ok, pkt_id = self._send_pkt("QUEUE_MOVE", args, note="queue_move")
+        if ok:
+            self._wait_for_reply(gcmd, pkt_id, gcmd.get_float("WAIT", 0.0))
+
+    def cmd_BMCU_WAIT_QUEUE(self, gcmd):
+        # Block until the lane's queue has drained (SEGMENT_DONE left=0)
+        lane = str(gcmd.get_int("LANE", 0, minval=0, maxval=3))
+        timeout = gcmd.get_float("TIMEOUT", 60.0, above=0.)
+        start_seq = self._queue_sent_seq.pop(lane, None)
+        if start_seq is None:
+            gcmd.respond_info(f"BMCU: nothing queued on lane {lane}")
+            return
+        end = self.reactor.monotonic() + timeout
+        while self.reactor.monotonic() < end:
+            self.reactor.pause(self.reactor.monotonic() + 0.05)
+            res = self.segment_results.get(lane)
+            if res and res["seq"] > start_seq and res["left"] == 0:
+                gcmd.respond_info(f"BMCU: lane {lane} queue done (last tag {res['tag']})")
+                return
+        raise gcmd.error(f"BMCU: lane {lane} queue not done within {timeout:.1f}s")
+
+    def cmd_BMCU_GROUP_MOVE(self, gcmd):
+        # Move several lanes starting on the same firmware tick, e.g.
+        # BMCU_GROUP_MOVE LANES=0,1 DISTS=-400,350 SPEEDS=120,80 WAIT_DONE=30
+        lanes = [int(x) for x in gcmd.get("LANES").split(",") if x.strip()]
+        dists = [float(x) for x in gcmd.get("DISTS").split(",") if x.strip()]
+        if len(lanes) != len(dists) or not lanes or any(l < 0 or l > 3 for l in lanes):
+            raise gcmd.error("BMCU_GROUP_MOVE: LANES and DISTS must match (lanes 0-3)")
+        speeds = gcmd.get("SPEEDS", None)
+        dist_mm = [0.0] * 4
+        for lane, dist in zip(lanes, dists):
+            dist_mm[lane] = self._clamp(dist, -self.max_move_mm, self.max_move_mm)
+        if speeds is not None:
+            vals = [float(x) for x in speeds.split(",") if x.strip()]
+            if len(vals) != len(lanes):
+                raise gcmd.error("BMCU_GROUP_MOVE: SPEEDS must match LANES")
+            speed = [0.0] * 4
+            for lane, v in zip(lanes, vals):
+                speed[lane] = self._clamp(abs(v), 0.0, self.max_speed)
+        else:
+            speed = self._clamp(gcmd.get_float("SPEED", self.default_speed, above=0.),
+                                0.0, self.max_speed)
+        args = {"dist_mm": dist_mm, "speed": speed}
+        accel = gcmd.get_float("ACCEL", None, minval=0.)
+        tol = gcmd.get_float("TOL", None, above=0.)
+        delay = gcmd.get_int("DELAY", 0, minval=0)
+        if accel is not None:
+            args["accel"] = accel
+        if gcmd.get_int("POS", 0):
+            args["pos"] = True
+            if tol is not None:
+                args["tol_mm"] = tol
+        if delay:
+            args["delay_ms"] = delay
+        tag = gcmd.get_int("TAG", 0, minval=0, maxval=65535)
+        args["tag"] = tag
+        wait_done = gcmd.get_float("WAIT_DONE", 0.0, minval=0.)
+        start_seq = self._move_done_seq
+        ok, pkt_id = self._send_pkt("GROUP_MOVE", args, note="group_move")
+        gcmd.respond_info(f"GROUP_MOVE lanes={lanes} dists={dists}")
+        if not ok or wait_done <= 0:
+            return
+        end = self.reactor.monotonic() + wait_done
+        while self.reactor.monotonic() < end:
+            self.reactor.pause(self.reactor.monotonic() + 0.05)
+            reply = self.last_rx_by_id.get(pkt_id)
+            if reply is not None and not reply.get("ok", True):
+                raise gcmd.error(f"BMCU: GROUP_MOVE rejected: {reply.get('code')}")
+            res = self.group_result
+            if res and res["seq"] > start_seq and res["tag"] == tag:
+                want = sum(1 << l for l in lanes)
+                if (res["lanes"] or 0) != want:
+                    raise gcmd.error(f"BMCU: group {tag} incomplete (lanes mask {res['lanes']})")
+                gcmd.respond_info(f"GROUP_MOVE done in {res['elapsed_ms']}ms")
+                return
+        raise gcmd.error(f"BMCU: no GROUP_DONE within {wait_done:.1f}s")
+
     def cmd_BMCU_FEED(self, gcmd):
         mm = gcmd.get_float("MM", self.default_lane_feed_mm)
         speed = gcmd.get_float("SPEED", self.default_speed)
@@ -693,6 +1396,213 @@ class BMCU:
             {"axis": str(lane), "dist_mm": float(-mm), "speed": float(abs(speed))}, note="lane_retract")
         gcmd.respond_info(f"Lane {lane} RETRACT {mm}mm")
 
+    def cmd_BMCU_TIME_SYNC(self, gcmd):
+        stamps = gcmd.get_int("STAMPS", None)
+        if stamps is not None:
+            self.latency_stamps = bool(stamps)
+        self._time_sync(bursts=gcmd.get_int("COUNT", 4, minval=1, maxval=16))
+        c = self.clock
+        if c.offset is None:
+            gcmd.respond_info("BMCU: no TIME_SYNC reply yet")
+            return
+        gcmd.respond_info(
+            "BMCU clock: offset=%.6fs drift=%.1fppm min_rtt=%.2fms samples=%d stamps=%s"
+            % (c.offset, c.drift * 1e6, c.min_rtt * 1e3, len(c.samples),
+               self.latency_stamps))
+
+    def cmd_BMCU_COMM_STATS(self, gcmd):
+        reset = bool(gcmd.get_int("RESET", 0))
+        wait_s = gcmd.get_float("WAIT", 0.5)
+        ok, pkt_id = self._send_pkt("COMM_STATS", {"reset": reset}, note="comm_stats")
+        gcmd.respond_info(f"COMM_STATS sent id={pkt_id} busy_retries_host={self.busy_count}")
+        if ok:
+            self._wait_for_reply(gcmd, pkt_id, wait_s)
+
+    def cmd_BMCU_FLASH_STATS(self, gcmd):
+        # erases=[journal,log_a,log_b] are lifetime counts; RESET clears the rest
+        reset = bool(gcmd.get_int("RESET", 0))
+        wait_s = gcmd.get_float("WAIT", 0.5)
+        ok, pkt_id = self._send_pkt("FLASH_STATS", {"reset": reset}, note="flash_stats")
+        gcmd.respond_info(f"FLASH_STATS sent id={pkt_id}")
+        if ok:
+            self._wait_for_reply(gcmd, pkt_id, wait_s)
+
+    def cmd_BMCU_MOTOR_MODEL(self, gcmd):
+        # Learned feedforward curves: per lane feed/retract [pwm0, slope x100, samples].
+        # RESET=1 [LANE=n] forgets them, SAVE=1 persists the current fit now.
+        args = {}
+        if gcmd.get_int("RESET", 0):
+            args["reset"] = True
+            lane = gcmd.get_int("LANE", None, minval=0, maxval=3)
+            if lane is not None:
+                args["lane"] = lane
+        elif gcmd.get_int("SAVE", 0):
+            args["save"] = True
+        ok, pkt_id = self._send_pkt("MOTOR_MODEL", args, note="motor_model")
+        if not ok:
+            return
+        wait_s = gcmd.get_float("WAIT", 0.5)
+        end = self.reactor.monotonic() + wait_s
+        while self.reactor.monotonic() < end:
+            self.reactor.pause(self.reactor.monotonic() + 0.05)
+            reply = self.last_rx_by_id.get(pkt_id)
+            if reply is None:
+                continue
+            for i, lane in enumerate(reply.get("lanes", [])):
+                parts = []
+                for name in ("feed", "retract"):
+                    pwm0, slope, n = lane.get(name, [0, 0, 0])
+                    if slope:
+                        parts.append(f"{name} pwm={pwm0}+{slope / 100.0:.2f}*v (n={n})")
+                    else:
+                        parts.append(f"{name} not learned (n={n})")
+                gcmd.respond_info(f"lane {i}: " + ", ".join(parts))
+            return
+        gcmd.respond_info(f"BMCU: no reply within {wait_s:.2f}s (id={pkt_id})")
+
+    def cmd_BMCU_AUTOTUNE(self, gcmd):
+        # Relay autotune of one lane, e.g. BMCU_AUTOTUNE LANE=0 LOOP=speed APPLY=1
+        # LOOP=speed feeds the lane freely (~40mm/s, returned afterwards), so the
+        # filament must not be in the extruder; LOOP=buffer needs the filament
+        # loaded through the buffer and the extruder idle.  SAVE=1 persists.
+        lane = gcmd.get_int("LANE", minval=0, maxval=3)
+        loop = gcmd.get("LOOP", "speed").lower()
+        if loop not in ("speed", "buffer"):
+            raise gcmd.error("BMCU_AUTOTUNE: LOOP must be speed or buffer")
+        save = bool(gcmd.get_int("SAVE", 0))
+        apply = save or bool(gcmd.get_int("APPLY", 0))
+        wait_done = gcmd.get_float("WAIT_DONE", 30.0, minval=0.)
+        start_seq = self._move_done_seq
+        ok, pkt_id = self._send_pkt("AUTOTUNE", {"lane": lane, "loop": loop,
+                                                 "apply": apply, "save": save},
+                                    note="autotune")
+        if not ok:
+            raise gcmd.error("BMCU: not connected")
+        gcmd.respond_info(f"BMCU: autotuning lane {lane} {loop} loop...")
+        if wait_done <= 0:
+            return
+        end = self.reactor.monotonic() + wait_done
+        while self.reactor.monotonic() < end:
+            self.reactor.pause(self.reactor.monotonic() + 0.1)
+            reply = self.last_rx_by_id.get(pkt_id)
+            if reply is not None and not reply.get("ok", True):
+                raise gcmd.error(f"BMCU: AUTOTUNE rejected: {reply.get('code')}")
+            res = self.autotune_result
+            if not res or res["seq"] <= start_seq or res.get("lane") != lane:
+                continue
+            if res.get("status") != "ok":
+                raise gcmd.error(f"BMCU: lane {lane} autotune failed: {res.get('status')}")
+            kp = res.get("kp_x1000", 0) / 1000.0
+            ki = res.get("ki_x1000", 0) / 1000.0
+            prefix = "speed" if loop == "speed" else "buffer"
+            if res.get("applied"):
+                short = "spd" if loop == "speed" else "buf"
+                self.gains[short + "_kp"] = kp
+                self.gains[short + "_ki"] = ki
+            gcmd.respond_info(
+                f"BMCU: lane {lane} {loop} loop Ku={res.get('ku_x1000', 0) / 1000.0:.3f} "
+                f"Tu={res.get('tu_ms')}ms -> {prefix}_kp: {kp:.3f} {prefix}_ki: {ki:.3f}"
+                + (" (saved)" if res.get("saved") else
+                   " (applied)" if res.get("applied") else ""))
+            return
+        raise gcmd.error(f"BMCU: no AUTOTUNE_DONE within {wait_done:.1f}s")
+
+    # CaptureSample (MMU_Logic.h): t_ms, angle, speed x10, pressure mV, pwm
+    CAPTURE_SAMPLE = struct.Struct("<HHhHh")
+
+    def _request(self, gcmd, cmd, args, wait_s=1.0):
+        # Send and wait for the reply frame; raises on timeout or error reply
+        ok, pkt_id = self._send_pkt(cmd, args, note=cmd.lower())
+        if not ok:
+            raise gcmd.error("BMCU: not connected")
+        end = self.reactor.monotonic() + wait_s
+        while self.reactor.monotonic() < end:
+            self.reactor.pause(self.reactor.monotonic() + 0.02)
+            reply = self.last_rx_by_id.get(pkt_id)
+            if reply is None:
+                continue
+            if not reply.get("ok", True):
+                raise gcmd.error(f"BMCU: {cmd} rejected: {reply.get('code')}")
+            return reply
+        raise gcmd.error(f"BMCU: no {cmd} reply within {wait_s:.1f}s")
+
+    def cmd_BMCU_CAPTURE(self, gcmd):
+        # Step response for system identification, e.g.
+        # BMCU_CAPTURE LANE=0 MODE=pwm STEP=700 PRE=20 EVERY=2 FILE=/tmp/cap.csv
+        # MODE=pwm steps the drive open loop, MODE=vel steps the speed
+        # setpoint (mm/s).  Fit the CSV with Klipper/bmcu_sysid.py.
+        lane = gcmd.get_int("LANE", minval=0, maxval=3)
+        mode = gcmd.get("MODE", "pwm").lower()
+        if mode not in ("pwm", "vel"):
+            raise gcmd.error("BMCU_CAPTURE: MODE must be pwm or vel")
+        step = gcmd.get_float("STEP")
+        pre = gcmd.get_int("PRE", 20, minval=0)
+        every = gcmd.get_int("EVERY", 1, minval=1, maxval=50)
+        path = gcmd.get("FILE", f"/tmp/bmcu_capture_lane{lane}.csv")
+        wait_done = gcmd.get_float("WAIT_DONE", 30.0, above=0.)
+        start_seq = self._move_done_seq
+        self._request(gcmd, "CAPTURE", {"lane": lane, "mode": mode, "step": step,
+                                        "pre": pre, "every": every})
+        end = self.reactor.monotonic() + wait_done
+        while True:
+            res = self.capture_result
+            if res and res["seq"] > start_seq:
+                break
+            if self.reactor.monotonic() >= end:
+                raise gcmd.error(f"BMCU: no CAPTURE_DONE within {wait_done:.1f}s")
+            self.reactor.pause(self.reactor.monotonic() + 0.05)
+
+        rows = []
+        while True:
+            reply = self._request(gcmd, "CAPTURE_READ", {"offset": len(rows)})
+            data = base64.b64decode(reply.get("data", ""))
+            rows.extend(self.CAPTURE_SAMPLE.iter_unpack(data))
+            if not reply.get("count") or len(rows) >= reply.get("total", 0):
+                break
+        with open(path, "w") as f:
+            f.write(f"# lane={lane} mode={mode} step={step:g} pre={pre} every={every}\n")
+            f.write("t_ms,angle,speed,pressure_v,pwm,setpoint\n")
+            for i, (t_ms, angle, speed_x10, mv, pwm) in enumerate(rows):
+                sp = step if (mode == "vel" and i >= pre) else 0.0
+                f.write(f"{t_ms},{angle},{speed_x10 / 10.0:.1f},{mv / 1000.0:.3f},{pwm},{sp:g}\n")
+        gcmd.respond_info(f"BMCU: captured {len(rows)} samples over "
+                          f"{res.get('duration_ms')}ms -> {path}")
+
+    # Trace event codes (TraceEvent in I_MMU_Hardware.h); entries are [ms, event, arg, value]
+    CRASH_TRACE_EVENTS = ("none", "boot", "command", "lane_state", "save", "compact",
+                          "journal_roll", "nvs_error", "host_timeout", "host_reconnect",
+                          "warm_restore")
+
+    def cmd_BMCU_CRASHLOG(self, gcmd):
+        clear = bool(gcmd.get_int("CLEAR", 0))
+        wait_s = gcmd.get_float("WAIT", 0.5)
+        ok, pkt_id = self._send_pkt("CRASHLOG", {"clear": clear}, note="crashlog")
+        gcmd.respond_info(f"CRASHLOG sent id={pkt_id} clear={clear}")
+        if ok:
+            self._wait_for_reply(gcmd, pkt_id, wait_s)
+        rep = self.last_rx_by_id.get(pkt_id)
+        if not (isinstance(rep, dict) and rep.get("present")):
+            return
+        lines = ["reset=%s resets=%s fault=%s mcause=%s mepc=%s mtval=%s sp=%s at %sms"
+                 % (rep.get("reset"), rep.get("resets"), rep.get("fault"), rep.get("mcause"),
+                    rep.get("mepc"), rep.get("mtval"), rep.get("sp"), rep.get("time_ms"))]
+        for t, ev, arg, val in rep.get("trace", []):
+            name = (self.CRASH_TRACE_EVENTS[ev] if 0 <= ev < len(self.CRASH_TRACE_EVENTS)
+                    else str(ev))
+            lines.append("  %10d %-14s arg=%d value=%d" % (t, name, arg, val))
+        gcmd.respond_info("BMCU crash report:\n" + "\n".join(lines))
+
+    def cmd_BMCU_LATENCY(self, gcmd):
+        if gcmd.get_int("RESET", 0):
+            self.latency.reset()
+            gcmd.respond_info("BMCU latency stats cleared")
+            return
+        lines = self._latency_lines()
+        if not lines:
+            gcmd.respond_info("BMCU: no latency samples yet")
+            return
+        gcmd.respond_info("BMCU latency:\n" + "\n".join(lines))
+
 
 def load_config(config):
     return BMCU(config)
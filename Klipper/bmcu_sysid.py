@@ -0,0 +1,166 @@
+#!/usr/bin/env python3
+"""
+Fit lane dynamics from a BMCU step-response capture.
+
+Usage:
+    python3 bmcu_sysid.py /tmp/bmcu_capture_lane0.csv [--lambda-ratio 1.0]
+
+The CSV comes from BMCU_CAPTURE (see bmcu.py).  The input is the applied
+drive (MODE=pwm) or the speed setpoint (MODE=vel); the output is lane speed,
+measured as raw encoder travel per sample period (the firmware's velocity
+observer is bypassed, so its lag does not end up in the model).
+Two discrete ARX models are fitted by least squares, with a constant term
+for offsets and a dead time searched over whole samples:
+
+    1st order:  y[k+1] = a*y[k] + b*u[k-d] + c
+    2nd order:  y[k+2] = a1*y[k+1] + a2*y[k] + b1*u[k+1-d] + b2*u[k-d] + c
+
+and converted to gain K, time constant tau / natural frequency wn and
+damping zeta, and dead time.  For MODE=pwm the first-order fit also gives
+lambda-tuned PI gains in the firmware's units (speed_kp / speed_ki, PWM per
+mm/s); use those with BMCU_SET_GAINS.
+"""
+
+import argparse
+import cmath
+import math
+import sys
+
+MAX_DEAD_SAMPLES = 10
+
+
+def lstsq(rows, target):
+    """Least squares via the normal equations (a handful of columns, no numpy)."""
+    n = len(rows[0])
+    ata = [[sum(r[i] * r[j] for r in rows) for j in range(n)] for i in range(n)]
+    atb = [sum(r[i] * t for r, t in zip(rows, target)) for i in range(n)]
+    for col in range(n):
+        piv = max(range(col, n), key=lambda i: abs(ata[i][col]))
+        if abs(ata[piv][col]) < 1e-12:
+            return None
+        ata[col], ata[piv] = ata[piv], ata[col]
+        atb[col], atb[piv] = atb[piv], atb[col]
+        for i in range(col + 1, n):
+            f = ata[i][col] / ata[col][col]
+            for j in range(col, n):
+                ata[i][j] -= f * ata[col][j]
+            atb[i] -= f * atb[col]
+    theta = [0.0] * n
+    for i in reversed(range(n)):
+        theta[i] = (atb[i] - sum(ata[i][j] * theta[j] for j in range(i + 1, n))) / ata[i][i]
+    rms = math.sqrt(sum((sum(a * b for a, b in zip(r, theta)) - t) ** 2
+                        for r, t in zip(rows, target)) / len(rows))
+    return theta, rms
+
+
+def best_fit(y, make_row, lag):
+    """Fit for each dead time, keeping the lowest residual: (rms, d, theta)."""
+    best = None
+    for d in range(MAX_DEAD_SAMPLES + 1):
+        ks = range(d + lag, len(y))
+        if len(ks) < 10:
+            break
+        fit = lstsq([make_row(k, d) for k in ks], [y[k] for k in ks])
+        if fit and (best is None or fit[1] < best[0]):
+            best = (fit[1], d, fit[0])
+    return best
+
+
+def load_capture(path):
+    meta = {}
+    t, y, u_pwm, u_sp = [], [], [], []
+    with open(path) as f:
+        for line in f:
+            line = line.strip()
+            if not line:
+                continue
+            if line.startswith("#"):
+                for item in line[1:].split():
+                    key, _, val = item.partition("=")
+                    meta[key] = val
+                continue
+            if line.startswith("t_ms"):
+                continue
+            t_ms, _angle, speed, _pressure, pwm, setpoint = line.split(",")
+            t.append(float(t_ms) / 1000.0)
+            y.append(float(speed))
+            u_pwm.append(float(pwm))
+            u_sp.append(float(setpoint))
+    mode = meta.get("mode", "pwm")
+    u = u_sp if mode == "vel" else u_pwm
+    return meta, t, u, y
+
+
+def fit_first_order(u, y, dt):
+    best = best_fit(y, lambda k, d: (y[k - 1], u[k - 1 - d], 1.0), 1)
+    if best is None:
+        return None
+    rms, d, (a, b, c) = best
+    if not 0.0 < a < 1.0:
+        return None
+    return {"K": b / (1.0 - a), "tau": -dt / math.log(a), "dead": d * dt,
+            "offset": c / (1.0 - a), "rms": rms}
+
+
+def fit_second_order(u, y, dt):
+    best = best_fit(y, lambda k, d: (y[k - 1], y[k - 2], u[k - 1 - d], u[k - 2 - d], 1.0), 2)
+    if best is None:
+        return None
+    rms, d, (a1, a2, b1, b2, c) = best
+    den = 1.0 - a1 - a2
+    if abs(den) < 1e-9:
+        return None
+    # Poles of z^2 - a1 z - a2, mapped back with s = ln(z) / dt
+    disc = cmath.sqrt(a1 * a1 + 4.0 * a2)
+    poles = [cmath.log((a1 + disc) / 2.0) / dt, cmath.log((a1 - disc) / 2.0) / dt]
+    if any(p.real >= 0 for p in poles):
+        return None
+    wn = math.sqrt(abs(poles[0] * poles[1]))
+    zeta = -(poles[0] + poles[1]).real / (2.0 * wn)
+    return {"K": (b1 + b2) / den, "wn": wn, "zeta": zeta, "dead": d * dt,
+            "offset": c / den, "rms": rms}
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.split("\n\n")[0])
+    parser.add_argument("capture", help="CSV written by BMCU_CAPTURE")
+    parser.add_argument("--lambda-ratio", type=float, default=1.0,
+                        help="closed-loop time constant as a multiple of tau (PI tuning)")
+    args = parser.parse_args()
+
+    meta, t, u, y = load_capture(args.capture)
+    if len(t) < 20:
+        sys.exit("capture too short")
+    steps = sorted(b - a for a, b in zip(t, t[1:]))
+    dt = steps[len(steps) // 2]
+    if dt <= 0:
+        sys.exit("capture has no time base")
+    mode = meta.get("mode", "pwm")
+    unit = "(mm/s)/PWM" if mode == "pwm" else "(mm/s)/(mm/s)"
+    print(f"lane {meta.get('lane', '?')} mode={mode} step={meta.get('step', '?')} "
+          f"samples={len(t)} dt={dt * 1000:.2f}ms")
+
+    fo = fit_first_order(u, y, dt)
+    if fo:
+        print(f"1st order: K={fo['K']:.4f} {unit} tau={fo['tau'] * 1000:.1f}ms "
+              f"dead={fo['dead'] * 1000:.1f}ms offset={fo['offset']:.2f} rms={fo['rms']:.2f}")
+    else:
+        print("1st order: no stable fit")
+
+    so = fit_second_order(u, y, dt)
+    if so:
+        print(f"2nd order: K={so['K']:.4f} {unit} wn={so['wn']:.2f}rad/s "
+              f"zeta={so['zeta']:.3f} dead={so['dead'] * 1000:.1f}ms rms={so['rms']:.2f}")
+    else:
+        print("2nd order: no stable fit")
+
+    if fo and mode == "pwm" and fo["K"] > 0:
+        # Lambda (IMC) tuning of PID_speed: Kp = tau / (K (lambda + dead)), Ti = tau
+        lam = args.lambda_ratio * fo["tau"]
+        kp = fo["tau"] / (fo["K"] * (lam + fo["dead"]))
+        ki = kp / fo["tau"]
+        print(f"suggested: BMCU_SET_GAINS SPEED_KP={kp:.3f} SPEED_KI={ki:.3f}")
+
+
+if __name__ == "__main__":
+    main()
@@ -22,7 +22,47 @@ namespace KlipperCLI {
     static bool last_was_cr = false;
     static JsonDocument doc;
     static char global_json_buf[1024]; // Shared buffer for all responses
-    static uint64_t last_activity_time = 0; // Track last serial activity for smart save timing
+    
+    // Space reserved at the end of global_json_buf so flow-control credit and
+    // latency stamps (device micros: line arrival, dispatch, TX start) can be
+    // spliced into any response.
+    static constexpr int FRAME_RESERVE = 64;
+    static constexpr int JSON_LIMIT = sizeof(global_json_buf) - FRAME_RESERVE;
+    static bool stamps_enabled = false;
+    static bool frame_in_dispatch = false;
+    static uint32_t frame_rx_us = 0;
+    static uint32_t frame_dispatch_us = 0;
+    
+    // Backpressure: lines lost to RX ring overrun or exceeding rx_buffer
+    static bool rx_overrun = false;
+    static bool rx_too_long = false;
+    
+    // Uptime (ms) of the first reply to a host request, 0 until then
+    static uint32_t first_reply_ms = 0;
+    
+    // Protocol-level health counters (link-level ones live in the transport)
+    struct CommCounters {
+        uint32_t frames_in;     // Lines received (any outcome)
+        uint32_t frames_out;    // Frames written
+        uint32_t busy;          // Lines lost to RX ring overrun
+        uint32_t too_long;      // Lines longer than rx_buffer
+        uint32_t empty;         // Empty lines
+        uint32_t garbage;       // Lines rejected by the ASCII guard
+        uint32_t parse_err;     // JSON parse failures
+        uint32_t unknown_cmd;   // Valid JSON, unknown "cmd"
+    };
+    static CommCounters counters = {};
+    
+    const char* ResetCauseName(ResetCause cause) {
+        switch (cause) {
+            case ResetCause::power_on: return "power_on";
+            case ResetCause::pin:      return "pin";
+            case ResetCause::software: return "software";
+            case ResetCause::watchdog: return "watchdog";
+            case ResetCause::low_power: return "low_power";
+        }
+        return "unknown";
+    }
 
     // Response Helper
     void WaitTX() {
@@ -34,13 +74,42 @@ namespace KlipperCLI {
         }
     }
 
+    // Send @p len bytes as one outgoing frame (counted in frames_out)
+    void WriteRaw(const char* buf, int len) {
+        if (!_transport || len <= 0) return;
+        counters.frames_out++;
+        _transport->Write((const uint8_t*)buf, len);
+    }
+
+    // Write a CRLF-terminated frame from global_json_buf. Replies to a
+    // received line get ,"rx_free":N (bytes the host may send) and, when
+    // stamps are enabled, ,"ts":[rx,dispatch,tx] before the closing brace.
+    void WriteFrame(int len) {
+        if (!_transport || len <= 0) return;
+        uint32_t tx_us = micros();
+        if (frame_in_dispatch && len >= 3 && len <= JSON_LIMIT &&
+            global_json_buf[len - 3] == '}' && global_json_buf[len - 2] == '\r' && global_json_buf[len - 1] == '\n') {
+            len -= 3;
+            len += snprintf(global_json_buf + len, sizeof(global_json_buf) - len,
+                ",\"rx_free\":%u", (unsigned)_transport->RxFree());
+            if (stamps_enabled) {
+                len += snprintf(global_json_buf + len, sizeof(global_json_buf) - len,
+                    ",\"ts\":[%lu,%lu,%lu]",
+                    (unsigned long)frame_rx_us, (unsigned long)frame_dispatch_us, (unsigned long)tx_us);
+            }
+            len += snprintf(global_json_buf + len, sizeof(global_json_buf) - len, "}\r\n");
+            if (!first_reply_ms) first_reply_ms = millis();
+        }
+        WriteRaw(global_json_buf, len);
+    }
+
     void SendResponse(JsonDocument& d) {
         if (!_transport) return;
         WaitTX();
-        size_t len = serializeJson(d, global_json_buf, sizeof(global_json_buf) - 2);
+        size_t len = serializeJson(d, global_json_buf, JSON_LIMIT - 2);
         global_json_buf[len++] = '\r';
         global_json_buf[len++] = '\n';
-        _transport->Write((const uint8_t*)global_json_buf, len);
+        WriteFrame(len);
     }
     
     void SendError(int id, const char* code, const char* msg) {
@@ -73,79 +142,389 @@ namespace KlipperCLI {
         LiteObject& t = doc["telemetry"].makeObject();
         t["version"] = "00.00.05.00"; 
         t["uptime"] = (int)millis();
+        // Compact link health summary; COMM_STATS has the full breakdown
+        TransportStats ts;
+        if (_transport) _transport->GetStats(ts);
+        else memset(&ts, 0, sizeof(ts));
+        t["rx_free"] = _transport ? (int)_transport->RxFree() : 0;
+        t["drop_bytes"] = (int)ts.rx_dropped;
+        t["drop_frames"] = (int)(counters.busy + counters.too_long);
+        t["line_err"] = (int)(ts.overrun + ts.framing + ts.noise + ts.parity);
+        t["parse_err"] = (int)(counters.empty + counters.garbage + counters.parse_err);
         
         SendResponse(doc);
     }
 
+    // Clock exchange for host-side offset/drift estimation. The host sends its
+    // monotonic time, we echo it with our micros at line arrival and TX start.
+    // Optional "stamps" toggles latency stamps on every response.
+    void HandleTimeSync(int id, JsonObject args) {
+        if (args["stamps"].isBool()) stamps_enabled = args["stamps"];
+        int host_ms = args["host_ms"] | 0;
+        
+        WaitTX();
+        uint32_t tx_us = micros();
+        int len = snprintf(global_json_buf, JSON_LIMIT,
+            "{\"id\":%d,\"cmd\":\"TIME_SYNC\",\"ok\":true,\"host_ms\":%d,\"rx_us\":%lu,\"tx_us\":%lu,\"stamps\":%s}\r\n",
+            id, host_ms, (unsigned long)frame_rx_us, (unsigned long)tx_us, stamps_enabled ? "true" : "false");
+        if (len < 0 || len >= JSON_LIMIT) {
+            SendError(id, "BUFFER_OVERFLOW", "Response too large");
+            return;
+        }
+        WriteFrame(len);
+    }
+
+    // Full link/protocol health counters. {"reset":true} zeroes them after reporting.
+    void HandleCommStats(int id, JsonObject args) {
+        TransportStats ts;
+        if (_transport) _transport->GetStats(ts);
+        else memset(&ts, 0, sizeof(ts));
+        
+        WaitTX();
+        int len = snprintf(global_json_buf, JSON_LIMIT,
+            "{\"id\":%d,\"cmd\":\"COMM_STATS\",\"ok\":true,\"uptime\":%lu,"
+            "\"rx_bytes\":%lu,\"tx_bytes\":%lu,\"rx_dropped\":%lu,"
+            "\"overrun\":%lu,\"framing\":%lu,\"noise\":%lu,\"parity\":%lu,"
+            "\"frames_in\":%lu,\"frames_out\":%lu,\"busy\":%lu,\"too_long\":%lu,"
+            "\"empty\":%lu,\"garbage\":%lu,\"parse_err\":%lu,\"unknown_cmd\":%lu}\r\n",
+            id, (unsigned long)millis(),
+            (unsigned long)ts.rx_bytes, (unsigned long)ts.tx_bytes, (unsigned long)ts.rx_dropped,
+            (unsigned long)ts.overrun, (unsigned long)ts.framing, (unsigned long)ts.noise, (unsigned long)ts.parity,
+            (unsigned long)counters.frames_in, (unsigned long)counters.frames_out,
+            (unsigned long)counters.busy, (unsigned long)counters.too_long,
+            (unsigned long)counters.empty, (unsigned long)counters.garbage,
+            (unsigned long)counters.parse_err, (unsigned long)counters.unknown_cmd);
+        if (len < 0 || len >= JSON_LIMIT) {
+            SendError(id, "BUFFER_OVERFLOW", "Response too large");
+            return;
+        }
+        WriteFrame(len);
+        
+        if (args["reset"].isBool() && (bool)args["reset"]) {
+            memset(&counters, 0, sizeof(counters));
+            if (_transport) _transport->ResetStats();
+        }
+    }
+
+    void HandleFlashStats(int id, JsonObject args) {
+        if (!_mmu) return;
+        FlashStats fs;
+        _mmu->GetFlashStats(fs);
+        uint32_t lat_min = fs.nvs.batches ? fs.nvs.batch_us_min : 0;
+        uint32_t lat_avg = fs.nvs.batches ? fs.nvs.batch_us_total / fs.nvs.batches : 0;
+        
+        WaitTX();
+        int len = snprintf(global_json_buf, JSON_LIMIT,
+            "{\"id\":%d,\"cmd\":\"FLASH_STATS\",\"ok\":true,\"uptime\":%lu,"
+            "\"saves\":%lu,\"quiet\":%lu,\"forced\":%lu,\"compact\":%lu,\"rolls\":%lu,"
+            "\"fail\":%lu,\"fail_streak\":%u,\"delay_ms_max\":%lu,\"erases\":[%u,%u,%u],"
+            "\"hal_erases\":%lu,\"bytes\":%lu,\"nvs_err\":%lu,\"batches\":%lu,"
+            "\"lat_us\":[%lu,%lu,%lu],\"stall_us\":%lu,"
+            "\"log_free\":%u,\"journal_free\":%u,\"gen\":%lu,\"rejected\":%u}\r\n",
+            id, (unsigned long)millis(),
+            (unsigned long)fs.save.saves, (unsigned long)fs.save.quiet_saves,
+            (unsigned long)fs.save.forced_saves, (unsigned long)fs.save.compactions,
+            (unsigned long)fs.save.journal_rolls, (unsigned long)fs.save.failures,
+            (unsigned)fs.fail_streak,
+            (unsigned long)fs.save.delay_ms_max,
+            (unsigned)fs.wear.erases[WEAR_JOURNAL], (unsigned)fs.wear.erases[WEAR_LOG_A],
+            (unsigned)fs.wear.erases[WEAR_LOG_B],
+            (unsigned long)fs.nvs.erases, (unsigned long)fs.nvs.bytes_written,
+            (unsigned long)fs.nvs.errors, (unsigned long)fs.nvs.batches,
+            (unsigned long)lat_min, (unsigned long)lat_avg, (unsigned long)fs.nvs.batch_us_max,
+            (unsigned long)fs.nvs.stall_us_max,
+            (unsigned)fs.log_free, (unsigned)fs.journal_free,
+            (unsigned long)fs.log_generation, (unsigned)fs.log_rejected);
+        if (len < 0 || len >= JSON_LIMIT) {
+            SendError(id, "BUFFER_OVERFLOW", "Response too large");
+            return;
+        }
+        WriteFrame(len);
+        
+        if (args["reset"].isBool() && (bool)args["reset"]) {
+            _mmu->ResetFlashStats();
+        }
+    }
+
+    // Learned PWM/velocity curves per lane: [pwm0, slope x100, samples] for
+    // feed and retract; slope 0 = not learned. {"reset":true[,"lane":n]}
+    // forgets (all lanes by default), {"save":true} persists now.
+    void HandleMotorModel(int id, JsonObject args) {
+        if (!_mmu) return;
+        bool reset = args["reset"].isBool() && (bool)args["reset"];
+        bool save = args["save"].isBool() && (bool)args["save"];
+        int lane = args["lane"].isInt() ? (int)args["lane"] : -1;
+        
+        WaitTX();
+        int offset = snprintf(global_json_buf, JSON_LIMIT,
+            "{\"id\":%d,\"cmd\":\"MOTOR_MODEL\",\"ok\":true,\"lanes\":[", id);
+        for (int i = 0; i < 4 && offset > 0 && offset < JSON_LIMIT; i++) {
+            const MotorModel &mm = _mmu->GetMotorModel(i);
+            offset += snprintf(global_json_buf + offset, JSON_LIMIT - offset,
+                "%s{\"feed\":[%d,%d,%d],\"retract\":[%d,%d,%d]}", i ? "," : "",
+                (int)mm.dir[0].pwm0, (int)(mm.dir[0].slope * 100.0f), (int)mm.dir[0].s0,
+                (int)mm.dir[1].pwm0, (int)(mm.dir[1].slope * 100.0f), (int)mm.dir[1].s0);
+        }
+        if (offset > 0 && offset < JSON_LIMIT) {
+            offset += snprintf(global_json_buf + offset, JSON_LIMIT - offset, "]}\r\n");
+        }
+        if (offset <= 0 || offset >= JSON_LIMIT) {
+            SendError(id, "BUFFER_OVERFLOW", "Response too large");
+            return;
+        }
+        WriteFrame(offset);
+        
+        if (reset) _mmu->ResetMotorModel(lane);
+        else if (save) _mmu->SaveMotorModel();
+    }
+
+    const char* AutotuneStatusName(AutotuneStatus status) {
+        switch (status) {
+            case AutotuneStatus::ok:       return "ok";
+            case AutotuneStatus::running:  return "running";
+            case AutotuneStatus::no_cycle: return "no_cycle";
+            case AutotuneStatus::aborted:  return "aborted";
+            default:                       return "none";
+        }
+    }
+
+    // Body of an AUTOTUNE reply or AUTOTUNE_DONE event, after the opening
+    // fields. Gains are x1000: speed loop PWM per mm/s, buffer loop mm/s per V.
+    int FormatAutotune(char* buf, int size) {
+        const AutotuneResult &r = _mmu->GetAutotuneResult();
+        return snprintf(buf, size,
+            "\"lane\":%d,\"loop\":\"%s\",\"status\":\"%s\",\"cycles\":%d,"
+            "\"amp_x1000\":%ld,\"ku_x1000\":%ld,\"tu_ms\":%ld,\"kp_x1000\":%ld,\"ki_x1000\":%ld,"
+            "\"applied\":%s,\"saved\":%s}\r\n",
+            r.lane, r.loop == AutotuneLoop::buffer ? "buffer" : "speed", AutotuneStatusName(r.status),
+            r.cycles, (long)(r.amplitude * 1000.0f), (long)(r.ku * 1000.0f),
+            (long)(r.tu * 1000.0f), (long)(r.kp * 1000.0f), (long)(r.ki * 1000.0f),
+            r.applied ? "true" : "false", r.saved ? "true" : "false");
+    }
+
+    // Relay autotune: {"lane":n,"loop":"speed"|"buffer"} starts a test,
+    // reported by AUTOTUNE_DONE. "apply" adopts the gains for all lanes,
+    // "save" also persists them. Without "lane", returns the last result.
+    void HandleAutotune(int id, JsonObject args) {
+        if (!_mmu) return;
+        if (args["lane"].isInt()) {
+            int lane = args["lane"];
+            AutotuneLoop loop = AutotuneLoop::speed;
+            if (args["loop"].isString()) {
+                char name[16]; strncpy(name, args["loop"], 15); name[15] = 0;
+                if (strcmp(name, "buffer") == 0) loop = AutotuneLoop::buffer;
+                else if (strcmp(name, "speed") != 0) {
+                    SendError(id, "BAD_ARGS", "loop must be speed or buffer");
+                    return;
+                }
+            }
+            bool save = args["save"].isBool() && (bool)args["save"];
+            bool apply = save || (args["apply"].isBool() && (bool)args["apply"]);
+            if (lane < 0 || lane >= 4) {
+                SendError(id, "BAD_LANE", "Lane must be 0-3");
+                return;
+            }
+            if (_mmu->IsAutotuneActive()) {
+                SendError(id, "AUTOTUNE_BUSY", "Autotune in progress");
+                return;
+            }
+            if (!_mmu->StartAutotune(lane, loop, apply, save)) {
+                SendError(id, "NOT_READY", "Lane not loaded or buffer not engaged");
+                return;
+            }
+        }
+        
+        WaitTX();
+        int len = snprintf(global_json_buf, JSON_LIMIT,
+            "{\"id\":%d,\"cmd\":\"AUTOTUNE\",\"ok\":true,", id);
+        if (len > 0 && len < JSON_LIMIT) len += FormatAutotune(global_json_buf + len, JSON_LIMIT - len);
+        if (len <= 0 || len >= JSON_LIMIT) {
+            SendError(id, "BUFFER_OVERFLOW", "Response too large");
+            return;
+        }
+        WriteFrame(len);
+    }
+
+    // Step-response capture: {"lane":n,"mode":"pwm"|"vel","step":x} with
+    // optional "pre" (samples before the step) and "every" (ticks per
+    // sample). CAPTURE_DONE reports the end; CAPTURE_READ fetches samples.
+    void HandleCapture(int id, JsonObject args) {
+        if (!_mmu) return;
+        if (!args["lane"].isInt() || !args["step"].isFloat()) {
+            SendError(id, "BAD_ARGS", "Missing lane or step");
+            return;
+        }
+        CaptureConfig cfg;
+        int lane = args["lane"];
+        cfg.mode = CaptureMode::pwm;
+        if (args["mode"].isString()) {
+            char name[16]; strncpy(name, args["mode"], 15); name[15] = 0;
+            if (strcmp(name, "vel") == 0) cfg.mode = CaptureMode::velocity;
+            else if (strcmp(name, "pwm") != 0) {
+                SendError(id, "BAD_ARGS", "mode must be pwm or vel");
+                return;
+            }
+        }
+        cfg.step = args["step"];
+        int pre = args["pre"] | 20;
+        int every = args["every"] | 1;
+        if (lane < 0 || lane >= 4) {
+            SendError(id, "BAD_LANE", "Lane must be 0-3");
+            return;
+        }
+        cfg.lane = (uint8_t)lane;
+        cfg.pre_samples = (uint16_t)(pre < 0 ? 0 : pre);
+        cfg.every = (uint8_t)(every < 1 ? 1 : (every > CAPTURE_EVERY_MAX ? CAPTURE_EVERY_MAX : every));
+        if (!_mmu->StartCapture(cfg)) {
+            SendError(id, "CAPTURE_BUSY", "Capture or autotune running, or lane in use");
+            return;
+        }
+        doc.clear();
+        doc["id"] = id;
+        doc["cmd"] = "CAPTURE";
+        doc["ok"] = true;
+        doc["lane"] = lane;
+        doc["samples"] = CAPTURE_SAMPLES;
+        doc["sample_bytes"] = (int)sizeof(CaptureSample);
+        doc["every"] = (int)_mmu->GetCaptureConfig().every;
+        SendResponse(doc);
+    }
+
+    static const char BASE64_CHARS[] =
+        "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+
+    // Standard padded base64; returns the length written, or -1 if it does not fit
+    int Base64Encode(const uint8_t* src, int len, char* dst, int size) {
+        int out = 0;
+        for (int i = 0; i < len; i += 3) {
+            if (out + 4 >= size) return -1;
+            uint32_t v = (uint32_t)src[i] << 16;
+            if (i + 1 < len) v |= (uint32_t)src[i + 1] << 8;
+            if (i + 2 < len) v |= src[i + 2];
+            dst[out++] = BASE64_CHARS[(v >> 18) & 0x3F];
+            dst[out++] = BASE64_CHARS[(v >> 12) & 0x3F];
+            dst[out++] = i + 1 < len ? BASE64_CHARS[(v >> 6) & 0x3F] : '=';
+            dst[out++] = i + 2 < len ? BASE64_CHARS[v & 0x3F] : '=';
+        }
+        dst[out] = 0;
+        return out;
+    }
+
+    // Captured samples as base64 of the raw CaptureSample array, at most
+    // CAPTURE_READ_MAX per frame: {"offset":n[,"count":m]}. Samples
+    // recorded so far can be read while a capture is still running.
+    static constexpr int CAPTURE_READ_MAX = 60;
+    void HandleCaptureRead(int id, JsonObject args) {
+        if (!_mmu) return;
+        int total = _mmu->GetCaptureCount();
+        int offset = args["offset"] | 0;
+        int count = args["count"] | CAPTURE_READ_MAX;
+        if (offset < 0 || offset > total) {
+            SendError(id, "BAD_ARGS", "offset out of range");
+            return;
+        }
+        if (count > CAPTURE_READ_MAX) count = CAPTURE_READ_MAX;
+        if (count > total - offset) count = total - offset;
+        if (count < 0) count = 0;
+        const CaptureConfig &cfg = _mmu->GetCaptureConfig();
+        
+        WaitTX();
+        int len = snprintf(global_json_buf, JSON_LIMIT,
+            "{\"id\":%d,\"cmd\":\"CAPTURE_READ\",\"ok\":true,\"lane\":%d,\"mode\":\"%s\","
+            "\"done\":%s,\"total\":%d,\"offset\":%d,\"count\":%d,\"data\":\"",
+            id, cfg.lane, cfg.mode == CaptureMode::velocity ? "vel" : "pwm",
+            _mmu->IsCaptureActive() ? "false" : "true", total, offset, count);
+        if (len > 0 && len < JSON_LIMIT) {
+            int n = Base64Encode((const uint8_t*)(_mmu->GetCaptureSamples() + offset),
+                                 count * (int)sizeof(CaptureSample),
+                                 global_json_buf + len, JSON_LIMIT - len);
+            len = n < 0 ? -1 : len + n;
+        }
+        if (len > 0 && len < JSON_LIMIT) {
+            len += snprintf(global_json_buf + len, JSON_LIMIT - len, "\"}\r\n");
+        }
+        if (len <= 0 || len >= JSON_LIMIT) {
+            SendError(id, "BUFFER_OVERFLOW", "Response too large");
+            return;
+        }
+        WriteFrame(len);
+    }
+
+    // Post-mortem of the previous run: trap registers (if it faulted) and
+    // the trace leading up to the reset, oldest first.
+    void HandleCrashLog(int id, JsonObject args) {
+        if (!_mmu) return;
+        const CrashReport* r = _mmu->GetCrashReport();
+        WaitTX();
+        int len;
+        if (!r) {
+            len = snprintf(global_json_buf, JSON_LIMIT,
+                "{\"id\":%d,\"cmd\":\"CRASHLOG\",\"ok\":true,\"present\":false}\r\n", id);
+            WriteFrame(len);
+            return;
+        }
+        
+        len = snprintf(global_json_buf, JSON_LIMIT,
+            "{\"id\":%d,\"cmd\":\"CRASHLOG\",\"ok\":true,\"present\":true,"
+            "\"reset\":\"%s\",\"resets\":%u,\"fault\":%s,\"mcause\":\"0x%08lx\","
+            "\"mepc\":\"0x%08lx\",\"mtval\":\"0x%08lx\",\"sp\":\"0x%08lx\","
+            "\"time_ms\":%lu,\"trace\":[",
+            id, ResetCauseName((ResetCause)r->reset_cause), (unsigned)r->resets,
+            r->fault ? "true" : "false",
+            (unsigned long)r->mcause, (unsigned long)r->mepc,
+            (unsigned long)r->mtval, (unsigned long)r->sp, (unsigned long)r->time_ms);
+        
+        uint8_t count = r->trace_count <= TRACE_DEPTH ? r->trace_count : TRACE_DEPTH;
+        uint8_t start = (uint8_t)((r->trace_head + TRACE_DEPTH - count) % TRACE_DEPTH);
+        for (uint8_t n = 0; n < count && len > 0 && len < JSON_LIMIT; n++) {
+            const TraceEntry &e = r->trace[(start + n) % TRACE_DEPTH];
+            len += snprintf(global_json_buf + len, JSON_LIMIT - len, "%s[%lu,%u,%u,%u]",
+                n ? "," : "", (unsigned long)e.time_ms, (unsigned)e.event,
+                (unsigned)e.arg, (unsigned)e.value);
+        }
+        if (len > 0 && len < JSON_LIMIT) {
+            len += snprintf(global_json_buf + len, JSON_LIMIT - len, "]}\r\n");
+        }
+        if (len < 0 || len >= JSON_LIMIT) {
+            SendError(id, "BUFFER_OVERFLOW", "Response too large");
+            return;
+        }
+        WriteFrame(len);
+        
+        if (args["clear"].isBool() && (bool)args["clear"]) {
+            _mmu->ClearCrashReport();
+        }
+    }
+
     void HandleStatus(int id, JsonObject args) {
          if (!_mmu) return;
+         // Read one published snapshot so all lanes come from the same control tick
+         const StatusSnapshot &st = _mmu->GetStatus();
          WaitTX();
          int offset = 0;
-         offset += snprintf(global_json_buf + offset, sizeof(global_json_buf) - offset, 
+         offset += snprintf(global_json_buf + offset, JSON_LIMIT - offset, 
              "{\"id\":%d,\"cmd\":\"STATUS\",\"ok\":true,\"lanes\":[", id);
-             
-         uint16_t sensors = _mmu->GetSensorState();
          
          for(int i=0; i<4; i++) {
-            if(i > 0) offset += snprintf(global_json_buf + offset, sizeof(global_json_buf) - offset, ",");
+            if(i > 0) offset += snprintf(global_json_buf + offset, JSON_LIMIT - offset, ",");
             
-            int m_val = _mmu->GetLaneMotion(i);
-            const char* m_str = "Idle";
-            switch(m_val) {
-                case 0: m_str = "Idle"; break;
-                case 1: m_str = "Feed"; break;
-                case 2: m_str = "Retract"; break;
-                case 3: m_str = "SlowFeed"; break;
-                case 5: m_str = "AutoFeed"; break; 
-                case 7: m_str = "VelCtrl"; break;
-                default: m_str = "Idle"; break;
-            }
-            
-            FilamentState &f = _mmu->GetFilament(i);
-            
-            // Sanitize strings - replace non-printable chars with null terminator
-            char safe_id[9]; 
-            for(int j=0; j<8; j++) {
-                safe_id[j] = (f.ID[j] >= 32 && f.ID[j] < 127) ? f.ID[j] : '\0';
-                if(safe_id[j] == '\0') { safe_id[j] = '\0'; break; } // Stop at first non-printable
-            }
-            safe_id[8] = '\0';
-            
-            char safe_name[21];
-            for(int j=0; j<20; j++) {
-                safe_name[j] = (f.name[j] >= 32 && f.name[j] < 127) ? f.name[j] : '\0';
-                if(safe_name[j] == '\0') break;
-            }
-            safe_name[20] = '\0';
-            
-             float meters_f = f.meters;
-             if (!isfinite(meters_f)) meters_f = 0;
-             if (meters_f > 2000000000.0f) meters_f = 2000000000.0f;
-             if (meters_f < -2000000000.0f) meters_f = -2000000000.0f;
-
-             int m_int = (int)meters_f;
-             int m_dec = (int)((meters_f - m_int) * 100); 
-             if(m_dec < 0) m_dec = -m_dec; 
-            
-             int p_int = f.pressure / 1000;
-             int p_dec = f.pressure % 1000;
+            const LaneSnapshot &l = st.lanes[i];
             
-             if (offset >= (int)sizeof(global_json_buf) - 256) {
+             if (offset >= (int)JSON_LIMIT - 256) {
                  // Danger zone: not enough space for a full lane record
                  break; 
              }
-             
-             // Precision Fix: Handle negative sign for meters between -1.0 and 0.0
-             const char* sign = (meters_f < 0 && m_int == 0) ? "-" : "";
 
-             int n = snprintf(global_json_buf + offset, sizeof(global_json_buf) - offset, 
-                "{\"id\":%d,\"present\":%s,\"motion\":\"%s\",\"meters\":%s%d.%02d,\"pressure\":%d.%03d,\"rfid\":\"%s\",\"name\":\"%s\",\"temp_min\":%d,\"temp_max\":%d,\"color\":[%d,%d,%d,%d]}",
+             int n = snprintf(global_json_buf + offset, JSON_LIMIT - offset, 
+                "{\"id\":%d,\"present\":%s,\"motion\":\"%s\",\"meters\":%s%ld.%02d,\"pressure\":%d.%03d,\"rfid\":\"%s\",\"name\":\"%s\",\"temp_min\":%d,\"temp_max\":%d,\"color\":[%d,%d,%d,%d]}",
                 i, 
-                (sensors & (1<<i)) ? "true" : "false",
-                m_str, sign, m_int, m_dec, p_int, p_dec, safe_id, safe_name, f.temperature_min, f.temperature_max, f.color_R, f.color_G, f.color_B, f.color_A);
+                l.present ? "true" : "false",
+                l.motion_str, l.meters_neg ? "-" : "", (long)l.meters_int, l.meters_dec,
+                l.pressure_mv / 1000, l.pressure_mv % 1000, l.id, l.name,
+                l.temp_min, l.temp_max, l.color[0], l.color[1], l.color[2], l.color[3]);
              
              if (n > 0) {
-                 if (offset + n >= (int)sizeof(global_json_buf)) {
+                 if (offset + n >= (int)JSON_LIMIT) {
                      SendError(id, "BUFFER_OVERFLOW", "Status too large");
                      return;
                  }
@@ -154,16 +533,15 @@ namespace KlipperCLI {
          }
          
          // Finalize manually built JSON with closing array and object
-         // Finalize manually built JSON with closing array and object
-         int trailing = snprintf(global_json_buf + offset, sizeof(global_json_buf) - offset, "]}\r\n");
+         int trailing = snprintf(global_json_buf + offset, JSON_LIMIT - offset, "]}\r\n");
          
-         if (trailing < 0 || offset + trailing >= (int)sizeof(global_json_buf)) {
+         if (trailing < 0 || offset + trailing >= (int)JSON_LIMIT) {
              SendError(id, "BUFFER_OVERFLOW", "Status too large");
              return;
          }
          offset += trailing;
 
-         if (_transport) _transport->Write((const uint8_t*)global_json_buf, offset);
+         WriteFrame(offset);
     }
     
     void HandleGetSensors(int id, JsonObject args) {
@@ -173,7 +551,7 @@ namespace KlipperCLI {
          doc["cmd"] = "GET_SENSORS";
          doc["ok"] = true;
          
-         uint16_t state = _mmu->GetSensorState();
+         uint16_t state = _mmu->GetStatus().sensors;
          LiteArray& lanes = doc["lane"].makeArray();
          for(int i=0; i<4; i++) {
              lanes.add((state & (1<<i)) ? 1 : 0);
@@ -181,16 +559,16 @@ namespace KlipperCLI {
          SendResponse(doc);
     }
     
-    void HandleMove(int id, JsonObject args) {
-        if (!_mmu) return;
+    // Shared argument parsing for MOVE / MOVE_POS; replies and returns -1 on error
+    int ParseMoveArgs(int id, JsonObject args, float& dist, float& speed, float& accel, float& jerk) {
         if(!args["axis"].isString() || !args["dist_mm"].isFloat() || !args["speed"].isFloat()) {
              SendError(id, "BAD_ARGS", "Missing axis, dist, or speed"); 
-             return;
+             return -1;
         }
         
         char axis[16]; strncpy(axis, args["axis"], 15); axis[15]=0;
-        float dist = args["dist_mm"];
-        float speed = args["speed"];
+        dist = args["dist_mm"];
+        speed = args["speed"];
         
         int motor_idx = -1;
         if(strcmp(axis, "FEED") == 0) {
@@ -200,12 +578,136 @@ namespace KlipperCLI {
              motor_idx = atoi(axis);
         }
         
-        if (motor_idx >= 0 && motor_idx < 4) {
-             _mmu->MoveAxis(motor_idx, dist, speed);
-             SendOk(id, "MOVING", "Motion started");
-        } else {
+        // Optional per-move shaping; omitted uses the SET_CONFIG limits
+        accel = args["accel"].isFloat() ? (float)args["accel"] : -1.0f;
+        jerk = args["jerk"].isFloat() ? (float)args["jerk"] : -1.0f;
+        
+        if (motor_idx < 0 || motor_idx >= 4) {
              SendError(id, "BAD_AXIS", "Invalid or unknown axis");
+             return -1;
         }
+        return motor_idx;
+    }
+    
+    void HandleMove(int id, JsonObject args) {
+        if (!_mmu) return;
+        float dist, speed, accel, jerk;
+        int motor_idx = ParseMoveArgs(id, args, dist, speed, accel, jerk);
+        if (motor_idx < 0) return;
+        _mmu->MoveAxis(motor_idx, dist, speed, accel, jerk);
+        SendOk(id, "MOVING", "Motion started");
+    }
+
+    // Closed-loop move; completion is reported by a MOVE_DONE event
+    void HandleMovePos(int id, JsonObject args) {
+        if (!_mmu) return;
+        float dist, speed, accel, jerk;
+        int motor_idx = ParseMoveArgs(id, args, dist, speed, accel, jerk);
+        if (motor_idx < 0) return;
+        float tol = args["tol_mm"].isFloat() ? (float)args["tol_mm"] : -1.0f;
+        _mmu->MoveToPosition(motor_idx, dist, speed, accel, jerk, tol);
+        SendOk(id, "MOVING", "Position move started");
+    }
+
+    // Append a segment to the lane's move queue. Optional: "pos" for a
+    // closed-loop segment (with "tol_mm"), "delay_ms" to hold the start
+    // until that long after this frame arrived, and a "tag" echoed by
+    // SEGMENT_DONE. Jerk always comes from SET_CONFIG (LiteJSON key limit).
+    void HandleQueueMove(int id, JsonObject args) {
+        if (!_mmu) return;
+        float dist, speed, accel, jerk;
+        int motor_idx = ParseMoveArgs(id, args, dist, speed, accel, jerk);
+        if (motor_idx < 0) return;
+        if (dist == 0) {
+            SendError(id, "BAD_ARGS", "Queued moves need dist_mm");
+            return;
+        }
+        
+        MoveSegment seg;
+        seg.dist_mm = dist;
+        seg.speed = speed;
+        seg.accel = accel;
+        seg.jerk = jerk;
+        seg.tolerance_mm = args["tol_mm"].isFloat() ? (float)args["tol_mm"] : -1.0f;
+        seg.tag = (uint16_t)(args["tag"] | 0);
+        seg.flags = (args["pos"].isBool() && (bool)args["pos"]) ? MOVE_SEG_POSITION : 0;
+        seg.start_ms = 0;
+        int delay_ms = args["delay_ms"] | 0;
+        if (delay_ms > 0) {
+            // Measured from line arrival, so parse/queue time is not added on
+            int32_t late_ms = (int32_t)((micros() - frame_rx_us) / 1000);
+            seg.start_ms = (uint32_t)_mmu->GetTimeMS() + (uint32_t)(delay_ms - late_ms);
+            seg.flags |= MOVE_SEG_TIMED;
+        }
+        
+        if (!_mmu->QueueMove(motor_idx, seg)) {
+            SendError(id, "QUEUE_FULL", "Move queue full");
+            return;
+        }
+        doc.clear();
+        doc["id"] = id;
+        doc["cmd"] = "QUEUE_MOVE";
+        doc["ok"] = true;
+        doc["lane"] = motor_idx;
+        doc["queued"] = (int)_mmu->GetQueuedMoves(motor_idx);
+        SendResponse(doc);
+    }
+
+    // Start moves on several lanes on the same control tick. "dist_mm" is
+    // indexed by lane (0 = lane not moving); "speed" is one value for all
+    // lanes or an array like dist_mm. Shares "accel", "pos", "tol_mm",
+    // "delay_ms" and "tag" with QUEUE_MOVE; GROUP_DONE reports completion.
+    void HandleGroupMove(int id, JsonObject args) {
+        if (!_mmu) return;
+        if (!args["dist_mm"].isArray() || !(args["speed"].isFloat() || args["speed"].isArray())) {
+            SendError(id, "BAD_ARGS", "Missing dist_mm or speed");
+            return;
+        }
+        
+        MoveGroup group;
+        LiteArray& dist = args["dist_mm"].getArray();
+        bool speed_per_lane = args["speed"].isArray();
+        float speed_all = speed_per_lane ? 0.0f : (float)args["speed"];
+        for (int i = 0; i < 4; i++) {
+            group.dist_mm[i] = i < dist.size() ? (float)dist[i] : 0.0f;
+            group.speed[i] = speed_all;
+        }
+        if (speed_per_lane) {
+            LiteArray& speed = args["speed"].getArray();
+            for (int i = 0; i < 4 && i < speed.size(); i++) group.speed[i] = speed[i];
+        }
+        group.accel = args["accel"].isFloat() ? (float)args["accel"] : -1.0f;
+        group.jerk = -1.0f;
+        group.tolerance_mm = args["tol_mm"].isFloat() ? (float)args["tol_mm"] : -1.0f;
+        group.tag = (uint16_t)(args["tag"] | 0);
+        group.flags = (args["pos"].isBool() && (bool)args["pos"]) ? MOVE_SEG_POSITION : 0;
+        group.start_ms = 0;
+        int delay_ms = args["delay_ms"] | 0;
+        if (delay_ms > 0) {
+            int32_t late_ms = (int32_t)((micros() - frame_rx_us) / 1000);
+            group.start_ms = (uint32_t)_mmu->GetTimeMS() + (uint32_t)(delay_ms - late_ms);
+            group.flags |= MOVE_SEG_TIMED;
+        }
+        
+        if (_mmu->IsGroupActive()) {
+            SendError(id, "GROUP_BUSY", "Group move in progress");
+        } else if (!_mmu->StartMoveGroup(group)) {
+            SendError(id, "BAD_ARGS", "No lane to move");
+        } else {
+            SendOk(id, "ARMED", "Group move armed");
+        }
+    }
+
+    // Extruder velocity for AutoFeed feedforward, streamed by the host.
+    // Stops applying FEEDFORWARD_TIMEOUT_MS after the last frame.
+    void HandleExtruderVel(int id, JsonObject args) {
+        if (!_mmu) return;
+        if (!args["v"].isFloat()) {
+            SendError(id, "BAD_ARGS", "Missing v");
+            return;
+        }
+        _mmu->SetExtruderVelocity(args["v"]);
+        SendOk(id);
     }
 
     void HandleStop(int id, JsonObject args) {
@@ -268,49 +770,22 @@ namespace KlipperCLI {
          int lane = args["lane"];
          if(lane < 0 || lane >= 4) { SendError(id, "BAD_ARGS", "Invalid lane"); return; }
          
-         FilamentState &f = _mmu->GetFilament(lane);
-         
-         // Sanitize strings - replace non-printable chars with null terminator
-         char safe_id[9]; 
-         for(int j=0; j<8; j++) {
-             safe_id[j] = (f.ID[j] >= 32 && f.ID[j] < 127) ? f.ID[j] : '\0';
-             if(safe_id[j] == '\0') break;
-         }
-         safe_id[8] = '\0';
-         
-         char safe_name[21];
-         for(int j=0; j<20; j++) {
-             safe_name[j] = (f.name[j] >= 32 && f.name[j] < 127) ? f.name[j] : '\0';
-             if(safe_name[j] == '\0') break;
-         }
-         safe_name[20] = '\0';
-
-         float meters_f = f.meters;
-         if (!isfinite(meters_f)) meters_f = 0;
-         if (meters_f > 2000000000.0f) meters_f = 2000000000.0f;
-         if (meters_f < -2000000000.0f) meters_f = -2000000000.0f;
-
-         int m_int = (int)meters_f;
-         int m_dec = (int)((meters_f - m_int) * 100);
-         if(m_dec < 0) m_dec = -m_dec;
-         int p_int = f.pressure / 1000;
-         int p_dec = f.pressure % 1000;
+         const LaneSnapshot &l = _mmu->GetStatus().lanes[lane];
 
          WaitTX();
-         // Precision Fix: Handle negative sign for meters between -1.0 and 0.0
-         const char* sign = (meters_f < 0 && m_int == 0) ? "-" : "";
-
-         int len = snprintf(global_json_buf, sizeof(global_json_buf), 
-            "{\"id\":%d,\"cmd\":\"GET_FILAMENT_INFO\",\"ok\":true,\"lane\":%d,\"meters\":%s%d.%02d,\"pressure\":%d.%03d,\"rfid\":\"%s\",\"name\":\"%s\",\"temp_min\":%d,\"temp_max\":%d,\"color\":[%d,%d,%d,%d]}\r\n",
-            id, lane, sign, m_int, m_dec, p_int, p_dec, safe_id, safe_name, f.temperature_min, f.temperature_max, f.color_R, f.color_G, f.color_B, f.color_A
+         int len = snprintf(global_json_buf, JSON_LIMIT, 
+            "{\"id\":%d,\"cmd\":\"GET_FILAMENT_INFO\",\"ok\":true,\"lane\":%d,\"meters\":%s%ld.%02d,\"pressure\":%d.%03d,\"rfid\":\"%s\",\"name\":\"%s\",\"temp_min\":%d,\"temp_max\":%d,\"color\":[%d,%d,%d,%d]}\r\n",
+            id, lane, l.meters_neg ? "-" : "", (long)l.meters_int, l.meters_dec,
+            l.pressure_mv / 1000, l.pressure_mv % 1000, l.id, l.name,
+            l.temp_min, l.temp_max, l.color[0], l.color[1], l.color[2], l.color[3]
          );
          
-         if (len < 0 || len >= (int)sizeof(global_json_buf)) {
+         if (len < 0 || len >= (int)JSON_LIMIT) {
              SendError(id, "BUFFER_OVERFLOW", "Response too large");
              return;
          }
          
-         if (_transport) _transport->Write((const uint8_t*)global_json_buf, len);
+         WriteFrame(len);
     }
 
     void HandleSetFilamentInfo(int id, JsonObject args) {
@@ -357,11 +832,221 @@ namespace KlipperCLI {
          SendOk(id);
     }
 
+    // Runtime configuration. Each known key is optional; unknown keys are ignored.
+    void HandleSetConfig(int id, JsonObject args) {
+        if (!_mmu) return;
+        // Cascade gains; any subset may be given. Checked first so a
+        // rejected request changes nothing.
+        ControlGains g = _mmu->GetControlGains();
+        g.buffer_kp = args["buf_kp"] | g.buffer_kp;
+        g.buffer_ki = args["buf_ki"] | g.buffer_ki;
+        g.buffer_deadband = args["buf_db"] | g.buffer_deadband;
+        g.speed_kp = args["spd_kp"] | g.speed_kp;
+        g.speed_ki = args["spd_ki"] | g.speed_ki;
+        if (!_mmu->SetControlGains(g)) {
+            SendError(id, "BAD_ARGS", "Gains must be finite and >= 0");
+            return;
+        }
+        if (args["host_timeout_ms"].isInt()) {
+            int ms = args["host_timeout_ms"];
+            _mmu->SetHostTimeout(ms < 0 ? 0 : (uint32_t)ms);
+        }
+        if (args["move_accel"].isFloat() || args["move_jerk"].isFloat()) {
+            _mmu->SetMoveLimits(args["move_accel"] | _mmu->GetMoveAccel(),
+                                args["move_jerk"] | _mmu->GetMoveJerk());
+        }
+        doc.clear();
+        doc["id"] = id;
+        doc["cmd"] = "SET_CONFIG";
+        doc["ok"] = true;
+        doc["host_timeout_ms"] = (int)_mmu->GetHostTimeout();
+        doc["move_accel"] = _mmu->GetMoveAccel();
+        doc["move_jerk"] = _mmu->GetMoveJerk();
+        LiteObject& gains = doc["gains"].makeObject();
+        gains["buf_kp"] = g.buffer_kp;
+        gains["buf_ki"] = g.buffer_ki;
+        gains["buf_db"] = g.buffer_deadband;
+        gains["spd_kp"] = g.speed_kp;
+        gains["spd_ki"] = g.speed_ki;
+        SendResponse(doc);
+    }
+
+    // Encoder velocity observer: {"bw_hz":x} sets the bandwidth (0 = raw
+    // finite difference). Replies with the filtered lane speeds and the
+    // observer lag behind the measured position.
+    void HandleObserver(int id, JsonObject args) {
+        if (!_mmu) return;
+        if (args["bw_hz"].isFloat()) _mmu->SetObserverBandwidth(args["bw_hz"]);
+        doc.clear();
+        doc["id"] = id;
+        doc["cmd"] = "OBSERVER";
+        doc["ok"] = true;
+        doc["bw_hz"] = _mmu->GetObserverBandwidth();
+        LiteArray& speed = doc["speed"].makeArray();
+        LiteArray& lag = doc["lag_um"].makeArray();
+        for (int i = 0; i < 4; i++) {
+            speed.add(_mmu->GetLaneSpeed(i));
+            lag.add((int)(_mmu->GetObserverLag(i) * 1000.0f));
+        }
+        SendResponse(doc);
+    }
+
+    void HandleCaps(int id, JsonObject args);
+
+    // --- Command Table ---
+    struct CommandEntry {
+        const char* name;
+        void (*handler)(int id, JsonObject args);
+    };
+
+    static const CommandEntry command_table[] = {
+        { "PING", HandlePing },
+        { "CAPS", HandleCaps },
+        { "TIME_SYNC", HandleTimeSync },
+        { "COMM_STATS", HandleCommStats },
+        { "FLASH_STATS", HandleFlashStats },
+        { "CRASHLOG", HandleCrashLog },
+        { "MOTOR_MODEL", HandleMotorModel },
+        { "AUTOTUNE", HandleAutotune },
+        { "CAPTURE", HandleCapture },
+        { "CAPTURE_READ", HandleCaptureRead },
+        { "SET_CONFIG", HandleSetConfig },
+        { "OBSERVER", HandleObserver },
+        { "STATUS", HandleStatus },
+        { "GET_SENSORS", HandleGetSensors },
+        { "MOVE", HandleMove },
+        { "MOVE_POS", HandleMovePos },
+        { "QUEUE_MOVE", HandleQueueMove },
+        { "GROUP_MOVE", HandleGroupMove },
+        { "EXTRUDER_VEL", HandleExtruderVel },
+        { "STOP", HandleStop },
+        { "SELECT_LANE", HandleSelectLane },
+        { "SET_AUTO_FEED", HandleSetAutoFeed },
+        { "GET_FILAMENT_INFO", HandleGetFilamentInfo },
+        { "SET_FILAMENT_INFO", HandleSetFilamentInfo },
+    };
+    static constexpr int COMMAND_COUNT = sizeof(command_table) / sizeof(command_table[0]);
+
+    const CommandEntry* FindCommand(const char* cmd) {
+        for (int i = 0; i < COMMAND_COUNT; i++) {
+            if (strcmp(cmd, command_table[i].name) == 0) return &command_table[i];
+        }
+        return nullptr;
+    }
+
+    // Device capabilities and limits, plus the list of supported commands
+    void HandleCaps(int id, JsonObject args) {
+        WaitTX();
+        int offset = snprintf(global_json_buf, JSON_LIMIT,
+            "{\"id\":%d,\"cmd\":\"CAPS\",\"ok\":true,\"version\":\"00.00.05.00\",\"lanes\":4,"
+            "\"rx_buffer\":%d,\"line_max\":%d,\"host_timeout_ms\":%lu,\"ready\":%s,"
+            "\"first_reply_ms\":%lu,\"move_queue\":%d,\"cmds\":[",
+            id, (int)(_transport ? _transport->RxFree() + _transport->Available() + 1 : 0),
+            (int)sizeof(rx_buffer) - 1, (unsigned long)(_mmu ? _mmu->GetHostTimeout() : 0),
+            (_mmu && _mmu->IsHardwareReady()) ? "true" : "false",
+            (unsigned long)(first_reply_ms ? first_reply_ms : millis()), MOVE_QUEUE_DEPTH);
+        for (int i = 0; i < COMMAND_COUNT && offset > 0 && offset < JSON_LIMIT; i++) {
+            offset += snprintf(global_json_buf + offset, JSON_LIMIT - offset,
+                "%s\"%s\"", i ? "," : "", command_table[i].name);
+        }
+        if (offset > 0 && offset < JSON_LIMIT) {
+            offset += snprintf(global_json_buf + offset, JSON_LIMIT - offset, "]}\r\n");
+        }
+        if (offset <= 0 || offset >= JSON_LIMIT) {
+            SendError(id, "BUFFER_OVERFLOW", "Response too large");
+            return;
+        }
+        WriteFrame(offset);
+    }
+
+    // Lowest lane in a single-lane event's mask
+    int EventLane(const MMU_Event& ev) {
+        int lane = 0;
+        while (lane < 3 && !(ev.lane_mask & (1 << lane))) lane++;
+        return lane;
+    }
+
+    // Forward queued logic events to the host as unsolicited frames
+    void PumpEvents() {
+        if (!_mmu) return;
+        MMU_Event ev;
+        while (_mmu->PopEvent(ev)) {
+            WaitTX();
+            int len = 0;
+            switch (ev.type) {
+                case MMU_EventType::host_timeout:
+                    len = snprintf(global_json_buf, JSON_LIMIT,
+                        "{\"event\":\"HOST_TIMEOUT\",\"timeout_ms\":%ld,\"stopped\":%d}\r\n",
+                        (long)ev.a, ev.lane_mask);
+                    break;
+                case MMU_EventType::host_reconnect:
+                    len = snprintf(global_json_buf, JSON_LIMIT,
+                        "{\"event\":\"RECONNECT\",\"offline_ms\":%ld}\r\n", (long)ev.a);
+                    break;
+                case MMU_EventType::hw_ready:
+                    len = snprintf(global_json_buf, JSON_LIMIT,
+                        "{\"event\":\"READY\",\"ready_ms\":%ld,\"first_reply_ms\":%lu}\r\n",
+                        (long)ev.a, (unsigned long)first_reply_ms);
+                    break;
+                case MMU_EventType::move_done:
+                    len = snprintf(global_json_buf, JSON_LIMIT,
+                        "{\"event\":\"MOVE_DONE\",\"lane\":%d,\"error_um\":%ld,\"settled\":%s}\r\n",
+                        EventLane(ev), (long)ev.a, ev.b ? "true" : "false");
+                    break;
+                case MMU_EventType::segment_done:
+                    len = snprintf(global_json_buf, JSON_LIMIT,
+                        "{\"event\":\"SEGMENT_DONE\",\"lane\":%d,\"tag\":%ld,\"left\":%ld}\r\n",
+                        EventLane(ev), (long)ev.a, (long)ev.b);
+                    break;
+                case MMU_EventType::group_done:
+                    len = snprintf(global_json_buf, JSON_LIMIT,
+                        "{\"event\":\"GROUP_DONE\",\"tag\":%ld,\"lanes\":%d,\"elapsed_ms\":%ld}\r\n",
+                        (long)ev.a, ev.lane_mask, (long)ev.b);
+                    break;
+                case MMU_EventType::autotune_done:
+                    len = snprintf(global_json_buf, JSON_LIMIT, "{\"event\":\"AUTOTUNE_DONE\",");
+                    if (len > 0 && len < JSON_LIMIT) len += FormatAutotune(global_json_buf + len, JSON_LIMIT - len);
+                    break;
+                case MMU_EventType::capture_done:
+                    len = snprintf(global_json_buf, JSON_LIMIT,
+                        "{\"event\":\"CAPTURE_DONE\",\"lane\":%d,\"samples\":%ld,\"duration_ms\":%ld}\r\n",
+                        EventLane(ev), (long)ev.a, (long)ev.b);
+                    break;
+            }
+            if (len > 0 && len < JSON_LIMIT) WriteFrame(len);
+        }
+    }
+
+    // Best-effort "id" extraction from a line that cannot be parsed, so a
+    // BUSY/TOO_LONG reply can still be matched to the request by the host
+    int ScanId(const char* s) {
+        const char* p = strstr(s, "\"id\"");
+        if (!p) return 0;
+        p += 4;
+        while (*p == ' ' || *p == ':') p++;
+        return atoi(p);
+    }
+
+    // Reply to a line that was lost to RX overrun or exceeded rx_buffer
+    void RejectDroppedLine() {
+        if (rx_overrun) counters.busy++;
+        else counters.too_long++;
+        int id = ScanId(rx_buffer);
+        frame_dispatch_us = micros();
+        frame_in_dispatch = true;
+        if (rx_overrun) SendError(id, "BUSY", "RX overrun, resend");
+        else SendError(id, "TOO_LONG", "Line exceeds RX buffer");
+        frame_in_dispatch = false;
+        rx_overrun = false;
+        rx_too_long = false;
+    }
+
     void ProcessPacket(char* json_str) {
         // Guard against null or empty input
         if (!json_str || json_str[0] == '\0') {
+            counters.empty++;
             const char* err = "{\"ok\":false,\"msg\":\"JSON Parse Error\",\"error\":\"Empty packet\"}\n";
-            if (_transport) _transport->Write((const uint8_t*)err, strlen(err));
+            WriteRaw(err, strlen(err));
             return;
         }
         
@@ -369,9 +1054,10 @@ namespace KlipperCLI {
         for (int i = 0; json_str[i] != '\0'; i++) {
             unsigned char c = (unsigned char)json_str[i];
             if ((c < 32 && c != '\t' && c != '\r' && c != '\n') || c > 126) {
+                counters.garbage++;
                 WaitTX();
                 const char* err = "{\"ok\":false,\"msg\":\"JSON Parse Error\",\"error\":\"Binary garbage detected\"}\n";
-                if (_transport) _transport->Write((const uint8_t*)err, strlen(err));
+                WriteRaw(err, strlen(err));
                 return;
             }
         }
@@ -383,6 +1069,7 @@ namespace KlipperCLI {
 
         if (error) {
             // Debug: Echo back what was received (truncated to 100 chars)
+            counters.parse_err++;
             WaitTX();
             static char err_buf[256];
             char truncated[101];
@@ -391,7 +1078,7 @@ namespace KlipperCLI {
             snprintf(err_buf, sizeof(err_buf), 
                 "{\"ok\":false,\"msg\":\"JSON Parse Error\",\"received\":\"%s\",\"error\":\"%s\"}\n",
                 truncated, error.c_str());
-            if (_transport) _transport->Write((const uint8_t*)err_buf, strlen(err_buf));
+            WriteRaw(err_buf, strlen(err_buf));
             return;
         }
 
@@ -404,25 +1091,35 @@ namespace KlipperCLI {
 
         if (!cmd) return;
 
-        if (strcmp(cmd, "PING") == 0) HandlePing(id, args);
-        else if (strcmp(cmd, "STATUS") == 0) HandleStatus(id, args);
-        else if (strcmp(cmd, "GET_SENSORS") == 0) HandleGetSensors(id, args);
-        else if (strcmp(cmd, "MOVE") == 0) HandleMove(id, args);
-        else if (strcmp(cmd, "STOP") == 0) HandleStop(id, args);
-        else if (strcmp(cmd, "SELECT_LANE") == 0) HandleSelectLane(id, args);
-        else if (strcmp(cmd, "SET_AUTO_FEED") == 0) HandleSetAutoFeed(id, args);
-        else if (strcmp(cmd, "GET_FILAMENT_INFO") == 0) HandleGetFilamentInfo(id, args);
-        else if (strcmp(cmd, "SET_FILAMENT_INFO") == 0) HandleSetFilamentInfo(id, args);
+        frame_dispatch_us = micros();
+        frame_in_dispatch = true;
+
+        const CommandEntry* entry = FindCommand(cmd);
+        if (_mmu) _mmu->Trace(TraceEvent::command, entry ? (uint8_t)(entry - command_table) : 0xFF, (uint16_t)id);
+        if (entry) entry->handler(id, args);
         else {
+            counters.unknown_cmd++;
             SendError(id, "UNKNOWN_CMD", cmd);
         }
+        
+        frame_in_dispatch = false;
     }
 
     void Init(MMU_Logic* mmu, I_MMU_Transport* transport) {
         _mmu = mmu;
         _transport = transport;
-        const char* startup = "{\"event\":\"STARTUP\",\"msg\":\"KlipperCLI Ready\"}\r\n";
-        if (_transport) _transport->Write((const uint8_t*)startup, strlen(startup));
+        if (!_transport) return;
+        
+        char startup[192];
+        int len = snprintf(startup, sizeof(startup),
+            "{\"event\":\"STARTUP\",\"msg\":\"KlipperCLI Ready\",\"state\":\"%s\",\"boot_ms\":%lu,"
+            "\"reset\":\"%s\",\"warm\":%s,\"warm_restarts\":%u,\"crashlog\":%s}\r\n",
+            (_mmu && _mmu->IsHardwareReady()) ? "ready" : "warming", (unsigned long)millis(),
+            ResetCauseName(_mmu ? _mmu->GetResetCause() : ResetCause::power_on),
+            (_mmu && _mmu->IsWarmRestart()) ? "true" : "false",
+            (unsigned)(_mmu ? _mmu->GetWarmRestarts() : 0),
+            (_mmu && _mmu->GetCrashReport()) ? "true" : "false");
+        if (len > 0 && len < (int)sizeof(startup)) _transport->Write((const uint8_t*)startup, len);
     }
 
     void Run() {
@@ -443,32 +1140,29 @@ namespace KlipperCLI {
                 last_was_cr = (b == '\r');
                 
                 rx_buffer[rx_idx] = '\0';
-                last_activity_time = millis(); // Update activity timestamp for smart save timing
-                ProcessPacket(rx_buffer);
+                if (!_transport->PopLineTimestamp(&frame_rx_us)) frame_rx_us = micros();
+                counters.frames_in++;
+                if (rx_overrun || rx_too_long) RejectDroppedLine();
+                else ProcessPacket(rx_buffer);
                 rx_idx = 0;
             } else {
                 last_was_cr = false;
-                if (rx_idx < (int)sizeof(rx_buffer) - 1) {
+                if (b == I_MMU_Transport::RX_OVERRUN_MARKER) {
+                    // Transport dropped bytes of this line
+                    rx_overrun = true;
+                } else if (rx_idx < (int)sizeof(rx_buffer) - 1) {
                     rx_buffer[rx_idx++] = (char)b;
                 } else {
-                    // Buffer overflow - discard and reset
-                    rx_idx = 0; 
+                    // Line overflow - keep the head for id lookup, drop the rest
+                    rx_too_long = true;
                 }
             }
         }
+        
+        PumpEvents();
     }
     
     bool IsConnected() {
         return _transport && _transport->IsConnected();
     }
-    
-    // Returns true if no serial activity for the specified duration (ms)
-    bool IsSerialIdle(uint32_t idle_ms) {
-        return (millis() - last_activity_time) > idle_ms;
-    }
-}
-
-// Global wrapper for cross-module access (used by MMU_Logic for smart save timing)
-bool KlipperCLI_IsSerialIdle(uint32_t idle_ms) {
-    return KlipperCLI::IsSerialIdle(idle_ms);
 }
@@ -22,7 +22,4 @@ namespace KlipperCLI {
 
     // Check if connected
     bool IsConnected();
-    
-    // Check if serial has been idle for the specified duration
-    bool IsSerialIdle(uint32_t idle_ms);
 }
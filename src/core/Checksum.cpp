@@ -0,0 +1,30 @@
+/**
+ * @file Checksum.cpp
+ * @brief CRC implementations (see Checksum.h).
+ */
+#include "Checksum.h"
+
+// Bitwise: records are small, so no table is needed
+uint16_t Crc16(uint16_t crc, const uint8_t* data, uint16_t len) {
+    while (len--) {
+        crc ^= (uint16_t)(*data++) << 8;
+        for (int i = 0; i < 8; i++) {
+            crc = (crc & 0x8000) ? (uint16_t)((crc << 1) ^ 0x1021) : (uint16_t)(crc << 1);
+        }
+    }
+    return crc;
+}
+
+// Nibble table: small and fast enough to check a whole snapshot at boot
+uint32_t Crc32(uint32_t crc, const uint8_t* data, uint16_t len) {
+    static const uint32_t table[16] = {
+        0x00000000, 0x1DB71064, 0x3B6E20C8, 0x26D930AC, 0x76DC4190, 0x6B6B51F4, 0x4DB26158, 0x5005713C,
+        0xEDB88320, 0xF00F9344, 0xD6D6A3E8, 0xCB61B38C, 0x9B64C2B0, 0x86D3D2D4, 0xA00AE278, 0xBDBDF21C,
+    };
+    while (len--) {
+        crc ^= *data++;
+        crc = (crc >> 4) ^ table[crc & 0x0F];
+        crc = (crc >> 4) ^ table[crc & 0x0F];
+    }
+    return crc;
+}
@@ -0,0 +1,14 @@
+/**
+ * @file Checksum.h
+ * @brief CRCs shared by the persistence code.
+ */
+#pragma once
+
+#include <stdint.h>
+
+/// CRC-16/CCITT-FALSE (init 0xFFFF), bitwise.
+uint16_t Crc16(uint16_t crc, const uint8_t* data, uint16_t len);
+
+/// CRC-32 (IEEE, reflected). Pass and return the non-inverted register:
+/// start with 0xFFFFFFFF and invert the final value.
+uint32_t Crc32(uint32_t crc, const uint8_t* data, uint16_t len);
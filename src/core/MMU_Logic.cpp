@@ -1,7 +1,7 @@
 #include "MMU_Logic.h"
+#include "Checksum.h"
 #include <string.h>
 #include <stdio.h>
-#include "Flash_saves.h"
 
 // Hardware Config Macros (Ideally in config)
 #define MOTOR_INVERT_CH1 false
@@ -15,50 +15,135 @@
 #define MOTOR_PID_INVERT_CH4 true
 
 #define AS5600_PI 3.1415926535897932384626433832795
+#define AS5600_MM_PER_TICK (AS5600_PI * 7.5 / 4096)
+
+static constexpr int32_t ODO_JOURNAL_TICKS = (int32_t)(ODO_JOURNAL_MM / AS5600_MM_PER_TICK);
 
 // Unit Info
 #define DEVICE_MODEL "BMCU370"
 #define DEVICE_VERSION "00.00.05.00"
 #define DEVICE_SERIAL "00000000000000"
 
-// --- MotorChannel Helper Implementation ---
+// --- Status Snapshot Helpers ---
 
-float MotorChannel::CalculatePressureOutput(float current_pressure, float control_voltage, float time_E, pressure_control_enum control_type, float sign) {
-    float x=0;
-    switch (control_type) {
-        case pressure_control_enum::all:
-            x = sign * PID_pressure.Calculate(current_pressure - control_voltage, time_E);
-            break;
-        case pressure_control_enum::less_pressure:
-            if (current_pressure < control_voltage)
-                x = sign * PID_pressure.Calculate(current_pressure - control_voltage, time_E);
-            break;
-        case pressure_control_enum::over_pressure:
-            if (current_pressure > control_voltage)
-                x = sign * PID_pressure.Calculate(current_pressure - control_voltage, time_E);
-            break;
+// Copy printable ASCII up to the first non-printable char, always NUL terminated.
+static void SanitizeString(char* dst, const char* src, int max_len) {
+    int j = 0;
+    for (; j < max_len; j++) {
+        if (src[j] < 32 || src[j] >= 127) break;
+        dst[j] = src[j];
     }
-    if (x > 0) {
-        x = x * x / 250.0f;
-    } else {
-        x = -x * x / 250.0f;
+    dst[j] = '\0';
+}
+
+static const char* MotionName(filament_motion_enum m) {
+    switch (m) {
+        case filament_motion_enum::send: return "Feed";
+        case filament_motion_enum::pull: return "Retract";
+        case filament_motion_enum::slow_send: return "SlowFeed";
+        case filament_motion_enum::pressure_ctrl_in_use: return "AutoFeed";
+        case filament_motion_enum::velocity_control: return "VelCtrl";
+        case filament_motion_enum::position_control: return "PosCtrl";
+        case filament_motion_enum::autotune: return "Tune";
+        case filament_motion_enum::capture: return "Capture";
+        default: return "Idle";
     }
-    return x;
 }
 
+// --- MotorChannel Helper Implementation ---
+
 // --- MMU_Logic Implementation ---
 
-MMU_Logic::MMU_Logic(I_MMU_Hardware* hal) : _hal(hal) {
+static ControlGains DefaultControlGains() {
+    ControlGains g;
+    g.buffer_kp = BUFFER_KP_DEFAULT;
+    g.buffer_ki = BUFFER_KI_DEFAULT;
+    g.buffer_deadband = BUFFER_DEADBAND_DEFAULT;
+    g.speed_kp = SPEED_KP_DEFAULT;
+    g.speed_ki = SPEED_KI_DEFAULT;
+    return g;
+}
+
+// A NaN or negative gain would make the loops diverge, not just misbehave
+static bool ControlGainsValid(const ControlGains& g) {
+    const float fields[] = {g.buffer_kp, g.buffer_ki, g.buffer_deadband, g.speed_kp, g.speed_ki};
+    for (float f : fields) {
+        if (!isfinite(f) || f < 0) return false;
+    }
+    return true;
+}
+
+MMU_Logic::MMU_Logic(I_MMU_Hardware* hal)
+    : _hal(hal), settings_log(hal, NVS_SETTINGS_LOG_OFFSET, SETTINGS_LOG_PAGES),
+      odo_journal(hal, NVS_ODOMETRY_OFFSET) {
     // Defaults
     device_type_addr = BambuBus_AMS;
     Bambubus_need_to_save = false;
     save_timer = 0;
+    nvs_fail_streak = 0;
+    nvs_written = false;
+    nvs_retry_time = 0;
+    save_change_time = 0;
+    dirty_info = 0;
+    dirty_meters = 0;
+    dirty_global = false;
+    dirty_wear = false;
+    memset(&flash_wear, 0, sizeof(flash_wear));
+    memset(&save_stats, 0, sizeof(save_stats));
+    warm_state = nullptr;
+    warm_restarts = 0;
+    warm_chain = 0;
+    warm_restore_time = 0;
+    for (int i = 0; i < 4; i++) traced_lane_state[i] = 0;
+    hw_ready = false;
+    move_accel = MOVE_ACCEL_DEFAULT;
+    move_jerk = MOVE_JERK_DEFAULT;
+    memset(move_queue, 0, sizeof(move_queue));
+    extruder_velocity = 0;
+    extruder_velocity_time = 0;
+    control_gains = DefaultControlGains();
+    memset(motor_model, 0, sizeof(motor_model));
+    memset(&model_saved, 0, sizeof(model_saved));
+    dirty_model = false;
+    model_save_time = 0;
+    dirty_gains = false;
+    memset(&tune, 0, sizeof(tune));
+    tune_apply = false;
+    tune_save = false;
+    tune_relay = 0;
+    tune_periods = 0;
+    tune_prev_motion = filament_motion_enum::stop;
+    tune_bias = 0;
+    tune_max = 0;
+    tune_min = 0;
+    tune_amp_sum = 0;
+    tune_period_sum = 0;
+    tune_travel = 0;
+    tune_start_time = 0;
+    tune_period_start = 0;
+    memset(&capture_cfg, 0, sizeof(capture_cfg));
+    capture_count = 0;
+    capture_tick = 0;
+    capture_active = false;
+    capture_travel = 0;
+    capture_period_dist = 0;
+    capture_period_time = 0;
+    capture_start_time = 0;
+    memset(&move_group, 0, sizeof(move_group));
+    group_active = false;
+    group_started = false;
+    group_armed = 0;
+    group_running = 0;
+    group_finished = 0;
+    group_start_time = 0;
     
     // Init Arrays
     for(int i=0; i<4; i++) {
         motors[i].Init(i);
         filament_now_position[i] = filament_idle;
         speed_as5600[i] = 0;
+        dist_as5600[i] = 0;
+        observer_err[i] = 0;
         MC_PULL_stu_raw[i] = 0;
         MC_PULL_stu[i] = 0;
         MC_ONLINE_key_stu_raw[i] = 0;
@@ -68,11 +153,25 @@ MMU_Logic::MMU_Logic(I_MMU_Hardware* hal) : _hal(hal) {
         as5600_distance_save[i] = 0;
         unload_target_dist[i] = -1;
         unload_start_meters[i] = 0;
+        odo_ticks[i] = 0;
     }
+    memset(&odo_checkpoint, 0, sizeof(odo_checkpoint));
+    odo_roll_epoch = 0;
+    odo_flush_time = 0;
+    observer_bw_hz = OBSERVER_BW_DEFAULT_HZ;
     pull_state_old = false;
     is_backing_out = false;
     is_connected = false;
+    host_timed_out = false;
     last_heartbeat_time = 0;
+    host_lost_time = 0;
+    host_timeout_ms = HOST_TIMEOUT_DEFAULT_MS;
+    event_head = 0;
+    event_tail = 0;
+    
+    memset(status_buf, 0, sizeof(status_buf));
+    status_front = 0;
+    status_meta_dirty = 0x0F;
     
     // Initialize Data Save defaults before Load
     data_save.check = 0; // Invalid
@@ -81,6 +180,7 @@ MMU_Logic::MMU_Logic(I_MMU_Hardware* hal) : _hal(hal) {
 void MMU_Logic::Init() {
     _hal->Init();
     LoadSettings();
+    SetControlGains(control_gains);     // Persisted autotune results, if any
     // AS5600 Init moved to HAL Init inside _hal->Init()
     
     // Setup Motor Directions based on Config
@@ -101,54 +201,515 @@ void MMU_Logic::Init() {
         
         last_total_distance[i] = data_save.filament[i].meters;
     }
+    
+    uint16_t warm_len = 0;
+    void* warm_ram = _hal->GetRetainedRAM(warm_len);
+    if (warm_ram && warm_len >= sizeof(warm_state_block)) {
+        warm_state = (warm_state_block*)warm_ram;
+        if (_hal->GetResetCause() == ResetCause::power_on || !RestoreWarmState()) {
+            warm_state->magic = 0;
+        }
+    }
+    
+    status_meta_dirty = 0x0F;
+    PublishStatus(_hal->GetTimeMS());
 }
 
 void MMU_Logic::UpdateConnectivity(bool online) {
     is_connected = online;
-    if (online) last_heartbeat_time = _hal->GetTimeMS();
+    if (online) {
+        last_heartbeat_time = _hal->GetTimeMS();
+        if (host_timed_out) {
+            host_timed_out = false;
+            PushEvent(MMU_EventType::host_reconnect, 0, (int32_t)(last_heartbeat_time - host_lost_time));
+            _hal->Trace(TraceEvent::host_reconnect);
+        }
+    }
 }
 
-void MMU_Logic::SaveSettings() {
-    Flash_saves(&data_save, sizeof(data_save), use_flash_addr);
-    Bambubus_need_to_save = false;
+void MMU_Logic::SetHostTimeout(uint32_t ms) {
+    // 0 disables the watchdog; tiny values would trip between packets
+    if (ms != 0 && ms < HOST_TIMEOUT_MIN_MS) ms = HOST_TIMEOUT_MIN_MS;
+    host_timeout_ms = ms;
+}
+
+// Stop host-driven velocity moves when the host goes silent, so a crashed
+// host cannot leave a long MOVE running to its distance target.
+void MMU_Logic::CheckHostLiveness(uint64_t now) {
+    if (!is_connected || host_timeout_ms == 0) return;
+    if (now - last_heartbeat_time <= host_timeout_ms) return;
+    
+    is_connected = false;
+    host_timed_out = true;
+    host_lost_time = last_heartbeat_time;
+    
+    uint8_t stopped = 0;
+    for (int i = 0; i < 4; i++) {
+        ReleaseLane(i);
+        if (motors[i].IsHostMove()) {
+            motors[i].SetMotion(filament_motion_enum::pressure_ctrl_idle);
+            filament_now_position[i] = filament_idle;
+            stopped |= (1 << i);
+        }
+    }
+    PushEvent(MMU_EventType::host_timeout, stopped, (int32_t)host_timeout_ms);
+    _hal->Trace(TraceEvent::host_timeout, stopped);
+}
+
+void MMU_Logic::PushEvent(MMU_EventType type, uint8_t lane_mask, int32_t a, int32_t b) {
+    uint8_t next = (event_head + 1) % EVENT_QUEUE_SIZE;
+    if (next == event_tail) return; // Full: drop newest
+    MMU_Event &ev = event_queue[event_head];
+    ev.type = type;
+    ev.lane_mask = lane_mask;
+    ev.a = a;
+    ev.b = b;
+    event_head = next;
+}
+
+bool MMU_Logic::PopEvent(MMU_Event& ev) {
+    if (event_head == event_tail) return false;
+    ev = event_queue[event_tail];
+    event_tail = (event_tail + 1) % EVENT_QUEUE_SIZE;
+    return true;
+}
+
+// Worst-case save: a full snapshot into a fresh page, followed by an
+// odometry journal roll. Must fit the NVS write queue in one go, which is
+// why saves only start while NVS is idle.
+static constexpr uint16_t SETTINGS_SNAPSHOT_BYTES =
+    4 * (SettingsLog::RecordSize(sizeof(FilamentInfo)) + SettingsLog::RecordSize(sizeof(float))) +
+    SettingsLog::RecordSize(sizeof(settings_global_record)) +
+    SettingsLog::RecordSize(sizeof(settings_odometry_record)) +
+    SettingsLog::RecordSize(sizeof(settings_wear_record)) +
+    SettingsLog::RecordSize(sizeof(settings_motor_model_record)) +
+    SettingsLog::RecordSize(sizeof(ControlGains));
+static_assert(SETTINGS_SNAPSHOT_BYTES + SettingsLog::PAGE_OVERHEAD + OdometryJournal::FIRST_OFFSET
+              <= NVS_WRITE_QUEUE_MIN,
+              "Settings snapshot does not fit the NVS write queue");
+static_assert(WEAR_LOG_A + SETTINGS_LOG_PAGES == WEAR_PAGES, "One wear counter per settings page");
+
+// Settings are persisted as keyed records in SettingsLog. A save appends
+// only the groups marked dirty since they were last written; the page is
+// compacted (one erase) once it can no longer take a full snapshot.
+bool MMU_Logic::SaveSettings() {
+    bool ok = settings_log.IsMounted() &&
+              settings_log.FreeBytes() >= SETTINGS_SNAPSHOT_BYTES &&
+              AppendChangedSettings(false);
+    if (!ok) ok = CompactSettings();
+    _hal->Trace(TraceEvent::save, ok ? 1 : 0, settings_log.FreeBytes());
+    if (ok) {
+        if (Bambubus_need_to_save) {
+            uint32_t delay = (uint32_t)(_hal->GetTimeMS() - save_timer);
+            if (delay > save_stats.delay_ms_max) save_stats.delay_ms_max = delay;
+        }
+        save_stats.saves++;
+        Bambubus_need_to_save = false;
+        nvs_written = true;
+    } else {
+        save_stats.failures++;
+        save_timer = _hal->GetTimeMS(); // Retry after the next debounce window
+        NoteNVSFailure(save_timer);
+    }
+    return ok;
+}
+
+bool MMU_Logic::AppendChangedSettings(bool all) {
+    bool meters_written = false;
+    for (int i = 0; i < 4; i++) {
+        const FilamentState &f = data_save.filament[i];
+        uint8_t bit = (uint8_t)(1 << i);
+        if (all || (dirty_info & bit)) {
+            if (!settings_log.Append(SETTINGS_KEY_LANE_INFO | i, (const FilamentInfo*)&f, sizeof(FilamentInfo))) return false;
+            dirty_info &= ~bit;
+        }
+        if (all || (dirty_meters & bit)) {
+            if (!settings_log.Append(SETTINGS_KEY_LANE_METERS | i, &f.meters, sizeof(f.meters))) return false;
+            dirty_meters &= ~bit;
+            meters_written = true;
+        }
+    }
+    if (all || dirty_global) {
+        settings_global_record g = {};
+        g.now_filament_num = data_save.BambuBus_now_filament_num;
+        g.boot_mode = data_save.boot_mode;
+        g.filament_use_flag = data_save.filament_use_flag;
+        if (!settings_log.Append(SETTINGS_KEY_GLOBAL, &g, sizeof(g))) return false;
+        dirty_global = false;
+    }
+    if (all || dirty_wear) {
+        if (!settings_log.Append(SETTINGS_KEY_WEAR, &flash_wear, sizeof(flash_wear))) return false;
+        dirty_wear = false;
+    }
+    if (all || dirty_model) {
+        settings_motor_model_record rec;
+        PackMotorModel(rec);
+        if (!settings_log.Append(SETTINGS_KEY_MOTOR_MODEL, &rec, sizeof(rec))) return false;
+        model_saved = rec;
+        model_save_time = _hal->GetTimeMS();
+        dirty_model = false;
+    }
+    if (all || dirty_gains) {
+        if (!settings_log.Append(SETTINGS_KEY_GAINS | SETTINGS_GAINS_VERSION,
+                                 &control_gains, sizeof(control_gains))) return false;
+        dirty_gains = false;
+    }
+    if (all || meters_written || odo_roll_epoch) {
+        // Persisted meters now cover everything up to the journal's end,
+        // including ticks that were never journaled.
+        settings_odometry_record cp = {};
+        cp.epoch = odo_roll_epoch ? odo_roll_epoch : odo_journal.Epoch();
+        cp.offset = odo_roll_epoch ? OdometryJournal::FIRST_OFFSET : odo_journal.WriteOffset();
+        if (!settings_log.Append(SETTINGS_KEY_ODOMETRY, &cp, sizeof(cp))) return false;
+        odo_checkpoint = cp;
+        for (int i = 0; i < 4; i++) odo_ticks[i] = 0;
+    }
+    return true;
+}
+
+// Journal lane movement every ODO_JOURNAL_MM, or every ODO_JOURNAL_MS while
+// moving, so a reset loses at most that much consumption.
+void MMU_Logic::JournalOdometry(uint64_t now) {
+    // Records are only replayed for the epoch the settings checkpoint names
+    if (!odo_journal.IsMounted() || odo_journal.Epoch() != odo_checkpoint.epoch) return;
+    
+    bool timed = (now - odo_flush_time >= ODO_JOURNAL_MS);
+    if (timed) odo_flush_time = now;
+    for (int i = 0; i < 4; i++) {
+        int32_t t = odo_ticks[i];
+        if (t == 0 || (!timed && t < ODO_JOURNAL_TICKS && t > -ODO_JOURNAL_TICKS)) continue;
+        if (t > OdometryJournal::MAX_DELTA) t = OdometryJournal::MAX_DELTA;
+        if (t < -OdometryJournal::MAX_DELTA) t = -OdometryJournal::MAX_DELTA;
+        if (!odo_journal.Append(i, (int16_t)t)) return; // Full or writer busy: retry next tick
+        odo_ticks[i] -= t;
+    }
+}
+
+// Fold the journal into the settings store under a new epoch, then erase
+// it. Both go through the writer queue, so the fold lands first.
+void MMU_Logic::RollOdometry() {
+    uint32_t epoch = (odo_journal.Epoch() > odo_checkpoint.epoch ? odo_journal.Epoch() : odo_checkpoint.epoch) + 1;
+    odo_roll_epoch = epoch;
+    uint16_t erases = flash_wear.erases[WEAR_JOURNAL];
+    CountErase(WEAR_JOURNAL);       // Persisted with the fold
+    bool saved = SaveSettings();
+    odo_roll_epoch = 0;
+    if (saved) {
+        odo_journal.Roll(epoch);
+        save_stats.journal_rolls++;
+        _hal->Trace(TraceEvent::journal_roll, 0, (uint16_t)epoch);
+    } else {
+        flash_wear.erases[WEAR_JOURNAL] = erases;
+    }
+}
+
+void MMU_Logic::NoteNVSFailure(uint64_t now) {
+    if (nvs_fail_streak < 0xFF) nvs_fail_streak++;
+    uint8_t shift = nvs_fail_streak - 1 < 4 ? nvs_fail_streak - 1 : 4;
+    nvs_retry_time = now + ((uint64_t)SAVE_FORCE_MS << shift);
+}
+
+bool MMU_Logic::NVSRetryAllowed(uint64_t now) const {
+    return nvs_fail_streak < NVS_RETRY_LIMIT && now >= nvs_retry_time;
+}
+
+void MMU_Logic::CountErase(uint8_t page) {
+    if (flash_wear.erases[page] != 0xFFFF) flash_wear.erases[page]++;
+    dirty_wear = true;
+}
+
+void MMU_Logic::ApplyOdometryDelta(uint8_t lane, int16_t delta_ticks, void* ctx) {
+    MMU_Logic* self = (MMU_Logic*)ctx;
+    self->data_save.filament[lane].meters += (float)(delta_ticks * AS5600_MM_PER_TICK / 1000.0);
+    self->dirty_meters |= (uint8_t)(1 << lane);
+}
+
+// Start a fresh page holding a full snapshot. The previous page stays
+// authoritative until the new one is committed.
+bool MMU_Logic::CompactSettings() {
+    // On failure the log stays unmounted, so the retry compacts again.
+    if (!settings_log.BeginPage()) return false;
+    CountErase(WEAR_LOG_A + settings_log.Page());
+    if (!AppendChangedSettings(true) || !settings_log.CommitPage()) return false;
+    save_stats.compactions++;
+    _hal->Trace(TraceEvent::compact, settings_log.Page(), (uint16_t)settings_log.Generation());
+    return true;
+}
+
+void MMU_Logic::GetFlashStats(FlashStats& out) {
+    out.save = save_stats;
+    out.wear = flash_wear;
+    _hal->GetNVSStats(out.nvs);
+    out.log_free = settings_log.IsMounted() ? settings_log.FreeBytes() : 0;
+    out.journal_free = odo_journal.IsMounted() ? odo_journal.FreeRecords() : 0;
+    out.log_generation = settings_log.Generation();
+    out.log_rejected = settings_log.RejectedPages();
+    out.fail_streak = nvs_fail_streak;
+}
+
+// Runtime counters only; the persisted erase counts are lifetime values
+void MMU_Logic::ResetFlashStats() {
+    memset(&save_stats, 0, sizeof(save_stats));
+    _hal->ResetNVSStats();
 }
 
 void MMU_Logic::SetNeedToSave() {
+    save_change_time = _hal->GetTimeMS();
     if (!Bambubus_need_to_save) {
          Bambubus_need_to_save = true;
-         save_timer = _hal->GetTimeMS();
+         save_timer = save_change_time;
     }
 }
 
+void MMU_Logic::ApplySettingsRecord(uint8_t key, const uint8_t* data, uint8_t len, void* ctx) {
+    MMU_Logic* self = (MMU_Logic*)ctx;
+    uint8_t lane = key & 0x0F;
+    switch (key & 0xF0) {
+        case SETTINGS_KEY_LANE_INFO:
+            if (lane < 4 && len == sizeof(FilamentInfo)) {
+                FilamentInfo &f = self->data_save.filament[lane];
+                memcpy(&f, data, sizeof(FilamentInfo));
+                f.ID[sizeof(f.ID) - 1] = 0;
+                f.name[sizeof(f.name) - 1] = 0;
+            }
+            break;
+        case SETTINGS_KEY_LANE_METERS:
+            if (lane < 4 && len == sizeof(float)) {
+                memcpy(&self->data_save.filament[lane].meters, data, sizeof(float));
+            }
+            break;
+        case SETTINGS_KEY_ODOMETRY:
+            if (len == sizeof(settings_odometry_record)) {
+                memcpy(&self->odo_checkpoint, data, sizeof(settings_odometry_record));
+            }
+            break;
+        case SETTINGS_KEY_GLOBAL:
+            if (len == sizeof(settings_global_record)) {
+                settings_global_record g;
+                memcpy(&g, data, sizeof(g));
+                self->data_save.BambuBus_now_filament_num = g.now_filament_num;
+                self->data_save.boot_mode = g.boot_mode;
+                self->data_save.filament_use_flag = g.filament_use_flag;
+            }
+            break;
+        case SETTINGS_KEY_WEAR:
+            if (len == sizeof(settings_wear_record)) {
+                memcpy(&self->flash_wear, data, sizeof(settings_wear_record));
+            }
+            break;
+        case SETTINGS_KEY_MOTOR_MODEL:
+            if (len == sizeof(settings_motor_model_record)) {
+                memcpy(&self->model_saved, data, sizeof(settings_motor_model_record));
+                for (int i = 0; i < 4; i++) {
+                    for (int d = 0; d < 2; d++) {
+                        MotorModelDir &md = self->motor_model[i].dir[d];
+                        md.pwm0 = self->model_saved.pwm0[i][d];
+                        md.slope = self->model_saved.slope_x100[i][d] / 100.0f;
+                    }
+                }
+            }
+            break;
+        case SETTINGS_KEY_GAINS: {
+            // An unknown layout or out-of-range values fall back to the defaults
+            ControlGains g = DefaultControlGains();
+            if (lane == SETTINGS_GAINS_VERSION && len == sizeof(ControlGains)) {
+                memcpy(&g, data, sizeof(ControlGains));
+                if (!ControlGainsValid(g)) g = DefaultControlGains();
+            }
+            self->control_gains = g;
+            break;
+        }
+    }
+}
+
+void MMU_Logic::LoadDefaultSettings() {
+    // Default constants - set all 4 filaments to PLA defaults
+    for (int i = 0; i < 4; i++) {
+        data_save.filament[i].SetID("");  // Clear RFID
+        data_save.filament[i].SetName("PLA");
+        data_save.filament[i].temperature_min = 200;
+        data_save.filament[i].temperature_max = 220;
+        data_save.filament[i].meters = 0;
+        data_save.filament[i].pressure = 0;
+        data_save.filament[i].color_R = 0xFF;
+        data_save.filament[i].color_G = 0xFF;
+        data_save.filament[i].color_B = 0xFF;
+    }
+    data_save.boot_mode = 1; // Default to Klipper
+    data_save.version = 5;
+    data_save.check = 0x40614061;
+}
+
 void MMU_Logic::LoadSettings() {
-    flash_save_struct *ptr = (flash_save_struct *)(use_flash_addr);
-    if ((ptr->check == 0x40614061) && (ptr->version == data_save.version)) {
-        memcpy(&data_save, ptr, sizeof(data_save));
+    LoadDefaultSettings();
+    
+    if (settings_log.Mount()) {
+        settings_log.Replay(ApplySettingsRecord, this);
+        // Consumption journaled since the last persisted meters
+        if (odo_journal.Mount() && odo_journal.Epoch() == odo_checkpoint.epoch) {
+            odo_journal.Replay(odo_checkpoint.offset, ApplyOdometryDelta, this);
+        }
     } else {
-        // Default constants - set all 4 filaments to PLA defaults
-        for (int i = 0; i < 4; i++) {
-            data_save.filament[i].SetID("");  // Clear RFID
-            data_save.filament[i].SetName("PLA");
-            data_save.filament[i].temperature_min = 200;
-            data_save.filament[i].temperature_max = 220;
-            data_save.filament[i].meters = 0;
-            data_save.filament[i].pressure = 0;
-            data_save.filament[i].color_R = 0xFF;
-            data_save.filament[i].color_G = 0xFF;
-            data_save.filament[i].color_B = 0xFF;
+        // No log yet: migrate the legacy whole-struct page (left intact so
+        // older firmware still boots), or start from defaults.
+        flash_save_struct legacy;
+        if (_hal->ReadNVS((uint8_t*)&legacy, sizeof(legacy), NVS_LEGACY_SETTINGS_OFFSET) &&
+            (legacy.check == 0x40614061) && (legacy.version == data_save.version)) {
+            data_save = legacy;
         }
-        data_save.boot_mode = 1; // Default to Klipper
-        data_save.version = 5;
-        data_save.check = 0x40614061;
-        SetNeedToSave(); 
+        SetNeedToSave(); // Not mounted, so the first save compacts a full snapshot
     }
     
-    Motion_control_save_struct *mc_ptr = (Motion_control_save_struct *)(Motion_control_save_flash_addr);
-    if (mc_ptr->check == 0x40614061) {
-        memcpy(&mc_save, mc_ptr, sizeof(mc_save));
+    Motion_control_save_struct mc;
+    if (_hal->ReadNVS((uint8_t*)&mc, sizeof(mc), NVS_MOTION_CONTROL_OFFSET) && mc.check == 0x40614061) {
+        mc_save = mc;
     }
 }
 
+static uint32_t WarmStateCrc(const warm_state_block* w) {
+    return Crc32(0xFFFFFFFF, (const uint8_t*)w, offsetof(warm_state_block, crc)) ^ 0xFFFFFFFF;
+}
+
+// Resume in-flight lane operations from retained RAM. Settings have
+// already been loaded from NVS; the block overrides them with the newer
+// RAM view and re-marks anything unsaved as dirty.
+bool MMU_Logic::RestoreWarmState() {
+    const warm_state_block &w = *warm_state;
+    if (w.magic != WARM_STATE_MAGIC || w.version != WARM_STATE_VERSION ||
+        w.crc != WarmStateCrc(&w)) {
+        return false;
+    }
+    if (w.now_filament_num < 0 || w.now_filament_num >= 4) return false;
+    
+    for (int i = 0; i < 4; i++) {
+        const warm_lane_state &l = w.lanes[i];
+        if (l.position > filament_unloading ||
+            l.motion > (uint8_t)filament_motion_enum::capture) {
+            return false;
+        }
+    }
+    
+    warm_restarts = (uint16_t)(w.restarts + 1);
+    if (warm_restarts == 0) warm_restarts = 0xFFFF;
+    // Counters and dirty flags are always kept; motion only while the
+    // restarts are not a crash loop
+    bool resume = warm_restarts <= WARM_RESTART_MAX_RESUME;
+    
+    for (int i = 0; i < 4; i++) {
+        const warm_lane_state &l = w.lanes[i];
+        MotorChannel &m = motors[i];
+        data_save.filament[i].meters = l.meters;
+        data_save.filament[i].motion_set = (AMS_filament_motion)l.motion_set;
+        last_total_distance[i] = l.last_total_distance;
+        unload_start_meters[i] = l.unload_start_meters;
+        unload_target_dist[i] = l.unload_target_dist;
+        as5600_distance_save[i] = l.encoder_raw;
+        odo_ticks[i] = l.odo_ticks;
+        filament_now_position[i] = (filament_now_position_enum)l.position;
+        Assist_send_filament[i] = l.assist != 0;
+        m.motion = (filament_motion_enum)l.motion;
+        m.target_velocity = l.target_velocity;
+        m.target_distance = l.target_distance;
+        m.accumulated_distance = l.accumulated_distance;
+        m.PID_speed.SetIntegral(l.pid_speed_i);
+        m.PID_buffer.SetIntegral(l.pid_buffer_i);
+        if (!resume || m.motion == filament_motion_enum::autotune ||
+            m.motion == filament_motion_enum::capture) {
+            m.motion = filament_motion_enum::stop;  // Crash loops and experiments do not resume
+        } else if (m.motion == filament_motion_enum::velocity_control) {
+            // Re-accelerate from rest towards the remaining distance
+            m.profile.Start(m.target_distance, m.target_velocity, move_accel, move_jerk);
+        } else if (m.motion == filament_motion_enum::position_control) {
+            // Restart towards the original target from the position reached
+            float target = m.target_velocity < 0 ? -m.target_distance : m.target_distance;
+            m.motion = filament_motion_enum::stop;
+            MoveToPosition(i, target - m.accumulated_distance, fabsf(m.target_velocity));
+            m.PID_speed.SetIntegral(l.pid_speed_i);
+        }
+    }
+    data_save.BambuBus_now_filament_num = w.now_filament_num;
+    data_save.filament_use_flag = w.filament_use_flag;
+    SetHostTimeout(w.host_timeout_ms);
+    is_backing_out = resume && (w.flags & WARM_FLAG_BACKING_OUT) != 0;
+    pull_state_old = (w.flags & WARM_FLAG_PULL_OLD) != 0;
+    dirty_info |= w.dirty_info;
+    dirty_meters |= w.dirty_meters;
+    if (w.flags & WARM_FLAG_DIRTY_GLOBAL) dirty_global = true;
+    if (w.flags & WARM_FLAG_NEED_SAVE) SetNeedToSave();
+    
+    // Treat the host as present so the liveness timeout still guards
+    // resumed velocity moves if it never comes back.
+    is_connected = true;
+    last_heartbeat_time = _hal->GetTimeMS();
+    
+    warm_chain = warm_restarts;
+    warm_restore_time = _hal->GetTimeMS();
+    _hal->Trace(TraceEvent::warm_restore, resume ? 0 : 1, warm_restarts);
+    return true;
+}
+
+void MMU_Logic::OnHardwareReady(uint64_t now) {
+    hw_ready = true;
+    // A cold boot has no encoder history: take the first reading as the
+    // baseline instead of counting it as movement. A warm restart keeps
+    // its restored angle, so movement across the reset still counts.
+    if (!warm_restarts) {
+        for (int i = 0; i < 4; i++) as5600_distance_save[i] = _hal->GetEncoderValue(i);
+    }
+    PushEvent(MMU_EventType::hw_ready, 0, (int32_t)now);
+}
+
+// Trace lane position/motion transitions, so a crash report shows what
+// each lane was doing leading up to it.
+void MMU_Logic::TraceLaneStates() {
+    for (int i = 0; i < 4; i++) {
+        uint16_t state = (uint16_t)(((uint16_t)filament_now_position[i] << 8) | (uint8_t)motors[i].motion);
+        if (state != traced_lane_state[i]) {
+            traced_lane_state[i] = state;
+            _hal->Trace(TraceEvent::lane_state, (uint8_t)i, state);
+        }
+    }
+}
+
+void MMU_Logic::SaveWarmState() {
+    if (!warm_state) return;
+    warm_state_block &w = *warm_state;
+    
+    w.magic = WARM_STATE_MAGIC;
+    w.version = WARM_STATE_VERSION;
+    w.restarts = warm_chain;
+    w.now_filament_num = data_save.BambuBus_now_filament_num;
+    w.host_timeout_ms = host_timeout_ms;
+    w.filament_use_flag = data_save.filament_use_flag;
+    w.flags = (is_backing_out ? WARM_FLAG_BACKING_OUT : 0) |
+              (pull_state_old ? WARM_FLAG_PULL_OLD : 0) |
+              (Bambubus_need_to_save ? WARM_FLAG_NEED_SAVE : 0) |
+              (dirty_global ? WARM_FLAG_DIRTY_GLOBAL : 0);
+    w.dirty_info = dirty_info;
+    w.dirty_meters = dirty_meters;
+    for (int i = 0; i < 4; i++) {
+        warm_lane_state &l = w.lanes[i];
+        const MotorChannel &m = motors[i];
+        l.meters = data_save.filament[i].meters;
+        l.last_total_distance = last_total_distance[i];
+        l.unload_start_meters = unload_start_meters[i];
+        l.unload_target_dist = unload_target_dist[i];
+        l.encoder_raw = as5600_distance_save[i];
+        l.odo_ticks = odo_ticks[i];
+        l.target_velocity = m.target_velocity;
+        l.target_distance = m.target_distance;
+        l.accumulated_distance = m.accumulated_distance;
+        l.pid_speed_i = m.PID_speed.Integral();
+        l.pid_buffer_i = m.PID_buffer.Integral();
+        l.position = (uint8_t)filament_now_position[i];
+        l.motion = (uint8_t)m.motion;
+        l.motion_set = (uint8_t)data_save.filament[i].motion_set;
+        l.assist = Assist_send_filament[i] ? 1 : 0;
+    }
+    // A reset during the update leaves a stale CRC, i.e. a cold start
+    w.crc = WarmStateCrc(&w);
+}
+
 void MMU_Logic::MC_PULL_ONLINE_read() {
     for (int i = 0; i < 4; i++) {
         MC_PULL_stu_raw[i] = _hal->GetPressureReading(i);
@@ -223,11 +784,31 @@ void MMU_Logic::AS5600_Update(float time_E) {
         if (now > 3072 && last <= 1024) cir_E = -4096;
         else if (now <= 1024 && last > 3072) cir_E = 4096;
         
-        float dist_E = -(float)(now - last + cir_E) * AS5600_PI * 7.5 / 4096; 
+        int32_t ticks = -(now - last + cir_E);
+        float dist_E = (float)ticks * AS5600_MM_PER_TICK; 
         as5600_distance_save[i] = now;
+        odo_ticks[i] += ticks;
+        if (ticks) dirty_meters |= (uint8_t)(1 << i);
         
-        float speedx = dist_E / (time_E > 0 ? time_E : 0.001f);
-        speed_as5600[i] = speedx;
+        dist_as5600[i] = dist_E;
+        
+        // Alpha-beta observer: predict from the velocity estimate, then
+        // correct both with the residual. alpha = 2*w*dt and
+        // beta = (w*dt)^2 place both poles at w; w is capped at 0.5/dt to
+        // keep alpha <= 1 on slow ticks. Only the position error is kept,
+        // so the estimate stays exact however far the lane travels.
+        float w = 2.0f * (float)AS5600_PI * observer_bw_hz;
+        if (time_E <= 0) {
+            observer_err[i] += dist_E;      // Same ms tick: fold into the next update
+        } else if (w <= 0 || time_E > OBSERVER_MAX_DT) {
+            speed_as5600[i] = (observer_err[i] + dist_E) / time_E;
+            observer_err[i] = 0;
+        } else {
+            if (w * time_E > 0.5f) w = 0.5f / time_E;
+            float r = observer_err[i] + dist_E - speed_as5600[i] * time_E;
+            speed_as5600[i] += w * w * time_E * r;
+            observer_err[i] = r * (1.0f - 2.0f * w * time_E);
+        }
         
         data_save.filament[i].meters += dist_E / 1000.0f;
     }
@@ -257,20 +838,31 @@ void MMU_Logic::RunMotorChannel(int CHx, float time_E) {
     MotorChannel &m = motors[CHx];
     
     // Distance Accumulation
-    float dist_step = fabs(speed_as5600[CHx] * time_E);
+    float dist_step = fabsf(dist_as5600[CHx]);
     if (is_backing_out) {
         last_total_distance[CHx] += dist_step; 
     }
     if (m.motion == filament_motion_enum::velocity_control && m.target_distance > 0) {
          m.accumulated_distance += dist_step;
-         if (m.accumulated_distance >= m.target_distance) {
+         if (m.accumulated_distance >= m.target_distance && !AdvanceMoveQueue(CHx)) {
               m.SetMotion(filament_motion_enum::stop);
          }
+    } else if (m.motion == filament_motion_enum::position_control) {
+         m.accumulated_distance += dist_as5600[CHx];
+    }
+    
+    if (m.motion == filament_motion_enum::autotune || m.motion == filament_motion_enum::capture) {
+        float pwm = m.motion == filament_motion_enum::autotune ? RunAutotune(CHx, time_E)
+                                                               : RunCapture(CHx, time_E);
+        _hal->SetMotorPower(CHx, (int)pwm);
+        UpdateLEDStatus(CHx);
+        return;
     }
     
     float speed_set = 0;
     float now_speed = speed_as5600[CHx];
     float x = 0;
+    bool speed_loop = false;    // x comes from PID_speed tracking speed_set
     
     // Logic extraction from ControlLogic "Run" loop part
     if (m.motion == filament_motion_enum::pressure_ctrl_idle) { // Idle
@@ -298,22 +890,18 @@ void MMU_Logic::RunMotorChannel(int CHx, float time_E) {
                 x = 0; m.PID_pressure.Clear();
             }
         }
-    } else if (MC_ONLINE_key_stu[CHx] != 0 || m.motion == filament_motion_enum::velocity_control) { 
-        bool pid_invert = false;
-        switch(CHx) {
-            case 0: pid_invert = MOTOR_PID_INVERT_CH1; break;
-            case 1: pid_invert = MOTOR_PID_INVERT_CH2; break;
-            case 2: pid_invert = MOTOR_PID_INVERT_CH3; break;
-            case 3: pid_invert = MOTOR_PID_INVERT_CH4; break;
-        }
-        float pid_sign = m.dir * (pid_invert ? -1.0f : 1.0f);
-
+    } else if (MC_ONLINE_key_stu[CHx] != 0 || m.IsHostMove()) { 
          if (m.motion == filament_motion_enum::pressure_ctrl_in_use) {
              if (pull_state_old) {
+                 // Buffer is full from loading: let printing drain it first
                  if (MC_PULL_stu_raw[CHx] < 1.55f) pull_state_old = false;
+                 m.PID_speed.Clear();
+                 m.PID_buffer.Clear();
              } else {
-                 if (MC_PULL_stu_raw[CHx] < 1.65f) x = m.CalculatePressureOutput(MC_PULL_stu_raw[CHx], 1.65f, time_E, pressure_control_enum::less_pressure, pid_sign);
-                 else if (MC_PULL_stu_raw[CHx] > 1.7f) x = m.CalculatePressureOutput(MC_PULL_stu_raw[CHx], 1.7f, time_E, pressure_control_enum::over_pressure, pid_sign);
+                 speed_set = RunBufferLoop(CHx, time_E);
+                 if (IsFeedforwardLive()) speed_set += extruder_velocity;
+                 x = m.dir * m.PID_speed.Calculate(now_speed - speed_set, time_E);
+                 speed_loop = true;
              }
          } else {
              if (m.motion == filament_motion_enum::stop) {
@@ -328,21 +916,37 @@ void MMU_Logic::RunMotorChannel(int CHx, float time_E) {
              }
              if (m.motion == filament_motion_enum::slow_send) speed_set = MOTOR_SPEED_SLOW_SEND;
              if (m.motion == filament_motion_enum::pull) speed_set = -MOTOR_SPEED_PULL;
-             if (m.motion == filament_motion_enum::velocity_control) speed_set = m.target_velocity; 
+             if (m.motion == filament_motion_enum::velocity_control) {
+                 speed_set = m.profile.IsActive() ? m.profile.Step(m.accumulated_distance, time_E) : m.target_velocity;
+             }
+             if (m.motion == filament_motion_enum::position_control) {
+                 speed_set = RunPositionControl(CHx, time_E);
+                 if (m.motion == filament_motion_enum::stop) {
+                     _hal->SetMotorPower(CHx, 0);
+                     return;
+                 }
+             }
              
              x = m.dir * m.PID_speed.Calculate(now_speed - speed_set, time_E);
+             speed_loop = true;
          }
     } else {
         x = 0; 
     }
     
-    if (x > 10) x += m.pwm_zero;
+    // A learned model supplies the PWM for the setpoint, deadband included;
+    // otherwise fall back to the fixed pwm_zero offset.
+    float x_ff = speed_loop ? MotorModelPWM(CHx, speed_set) : 0.0f;
+    if (x_ff != 0) x += x_ff;
+    else if (x > 10) x += m.pwm_zero;
     else if (x < -10) x -= m.pwm_zero;
     else x = 0;
     
     if (x > 1000) x = 1000;
     if (x < -1000) x = -1000;
     
+    if (speed_loop) LearnMotorModel(CHx, speed_set, now_speed, x);
+    
     _hal->SetMotorPower(CHx, (int)x);
     UpdateLEDStatus(CHx);
 }
@@ -380,7 +984,7 @@ void MMU_Logic::motor_motion_switch() {
     // Logic mostly identical to before, updating member vars
     
     for (int i = 0; i < 4; i++) {
-        if (motors[i].motion == filament_motion_enum::velocity_control) continue;
+        if (motors[i].IsHostMove()) continue;
         if (motors[i].motion == filament_motion_enum::pressure_ctrl_in_use) continue;
 
         if (i != num) {
@@ -495,19 +1099,55 @@ void MMU_Logic::Run() {
     uint64_t now = _hal->GetTimeMS();
     float time_E = (now - last_run) / 1000.0f;
     last_run = now;
+    _hal->WatchdogReset();
+    
+    // Until the ADC filter and encoders are up, sensor readings are not
+    // trustworthy: keep the motors off and only advance the HAL bring-up.
+    if (!hw_ready) {
+        _hal->Service();
+        if (_hal->GetReadyMask() != HW_READY_ALL) return;
+        OnHardwareReady(now);
+    }
     
     MC_PULL_ONLINE_read();
     AS5600_Update(time_E);
+    CheckHostLiveness(now);
     
-    if (Bambubus_need_to_save) {
-        // Smart save timing: wait for serial silence to avoid blocking during communication
-        // Option 1: Save after 500ms of serial idle (fast response during dead time)
-        // Option 2: Force save after 5000ms absolute (safety fallback)
-        extern bool KlipperCLI_IsSerialIdle(uint32_t); // Forward declaration
-        bool serial_idle = KlipperCLI_IsSerialIdle(500); // 500ms of silence
-        bool timeout_hit = (now - save_timer > 5000);    // 5s absolute max
+    JournalOdometry(now);
+    
+    // NVS work is spread over ticks, so motors keep running during saves
+    _hal->Service();
+    if (_hal->TakeNVSError()) {
+        save_stats.failures++;
+        _hal->Trace(TraceEvent::nvs_error);
+        settings_log.Recover();
+        odo_journal.Mount();
+        SetNeedToSave();
+        nvs_written = false;
+        NoteNVSFailure(now);
+    } else if (nvs_written && !_hal->IsNVSBusy()) {
+        nvs_written = false;
+        nvs_fail_streak = 0;
+    }
+    
+    // Start a fresh journal epoch when full, or when it does not match the
+    // settings checkpoint (first boot, or a fold that was cut short). Held
+    // back by the same failure backoff as saves: each roll erases a page.
+    if (!_hal->IsNVSBusy() && NVSRetryAllowed(now) &&
+        (!odo_journal.IsMounted() || odo_journal.Epoch() != odo_checkpoint.epoch ||
+         odo_journal.FreeRecords() < 4)) {
+        RollOdometry();
+    }
+    
+    if (Bambubus_need_to_save && !_hal->IsNVSBusy() && NVSRetryAllowed(now)) {
+        // Debounce bursts of edits: save once changes settle, or after
+        // SAVE_FORCE_MS if they keep coming.
+        bool quiet = (now - save_change_time >= SAVE_QUIET_MS);
+        bool forced = (now - save_timer >= SAVE_FORCE_MS);
         
-        if (serial_idle || timeout_hit) { 
+        if (quiet || forced) { 
+            if (quiet) save_stats.quiet_saves++;
+            else save_stats.forced_saves++;
             SaveSettings(); 
         }
     }
@@ -519,10 +1159,20 @@ void MMU_Logic::Run() {
         motor_motion_switch();
     }
     
+    ServiceMoveGroup(now);
+    ServiceMoveQueues(now);
+    ServiceAutotune(now);
+    ServiceCapture();
+    
     for(int i=0; i<4; i++) {
         RunMotorChannel(i, time_E);
     }
     
+    PublishStatus(now);
+    TraceLaneStates();
+    if (warm_chain && now - warm_restore_time >= WARM_RESTART_STABLE_MS) warm_chain = 0;
+    SaveWarmState();
+    
     // System LED Debug Flash
     static uint64_t last_led_update = 0;
     if (now - last_led_update > 1000) {
@@ -603,6 +1253,7 @@ void MMU_Logic::SetFilamentInfoAction(int id, const FilamentInfo& info, float me
         
         if (target.meters != valid_meters) {
             target.meters = valid_meters;
+            dirty_meters |= (1 << id);
             changed = true;
         }
     }
@@ -610,14 +1261,15 @@ void MMU_Logic::SetFilamentInfoAction(int id, const FilamentInfo& info, float me
     target.ID[7] = 0; target.name[19] = 0;
     
     if (changed) {
+        status_meta_dirty |= (1 << id);
+        dirty_info |= (1 << id);
         SetNeedToSave();
     }
 }
 
 void MMU_Logic::StartLoadFilament(int tray, int length_mm) {
     if (tray < 0 || tray >= 4) return;
-    data_save.BambuBus_now_filament_num = tray;
-    data_save.filament_use_flag = 0x02; 
+    SetGlobalSelection(tray, 0x02);
     filament_now_position[tray] = filament_loading;
     motors[tray].SetMotion(filament_motion_enum::send); 
     unload_target_dist[tray] = length_mm; 
@@ -637,8 +1289,7 @@ void MMU_Logic::StartLoadFilament(int tray, int length_mm) {
 
 void MMU_Logic::StartUnloadFilament(int tray, int length_mm) {
     if (tray < 0 || tray >= 4) return;
-    data_save.BambuBus_now_filament_num = tray;
-    data_save.filament_use_flag = 0x02; 
+    SetGlobalSelection(tray, 0x02);
     filament_now_position[tray] = filament_unloading;
     motors[tray].SetMotion(filament_motion_enum::pull); 
     unload_target_dist[tray] = length_mm;
@@ -653,15 +1304,619 @@ void MMU_Logic::StartUnloadFilament(int tray, int length_mm) {
     }
 }
 
-void MMU_Logic::MoveAxis(int axis, float dist_mm, float speed) {
+void MMU_Logic::MoveAxis(int axis, float dist_mm, float speed, float accel, float jerk) {
+    if(axis < 0 || axis >= 4) return;
+    ReleaseLane(axis);
+    StartVelocityMove(axis, dist_mm, speed, accel, jerk);
+}
+
+void MMU_Logic::MoveToPosition(int axis, float dist_mm, float speed, float accel, float jerk,
+                               float tolerance_mm) {
     if(axis < 0 || axis >= 4) return;
-    motors[axis].target_velocity = speed;
-    motors[axis].target_distance = fabs(dist_mm); 
-    motors[axis].SetMotion(filament_motion_enum::velocity_control);
+    ReleaseLane(axis);
+    StartPositionMove(axis, dist_mm, speed, accel, jerk, tolerance_mm);
+}
+
+void MMU_Logic::StartVelocityMove(int axis, float dist_mm, float speed, float accel, float jerk) {
+    MotorChannel &m = motors[axis];
+    float velocity = (dist_mm < 0 || speed < 0) ? -fabsf(speed) : fabsf(speed);
+    // A new move while one is running blends from the current setpoint
+    float v_start = m.IsHostMove() ? m.profile.Velocity() : 0.0f;
+    
+    m.target_velocity = velocity;
+    m.target_distance = fabs(dist_mm); 
+    m.SetMotion(filament_motion_enum::velocity_control);
+    m.accumulated_distance = 0;
+    m.profile.Start(m.target_distance, velocity, accel < 0 ? move_accel : accel,
+                    jerk < 0 ? move_jerk : jerk, v_start);
+}
+
+void MMU_Logic::StartPositionMove(int axis, float dist_mm, float speed, float accel, float jerk,
+                                  float tolerance_mm) {
+    MotorChannel &m = motors[axis];
+    float velocity = (dist_mm < 0 || speed < 0) ? -fabsf(speed) : fabsf(speed);
+    float v_start = m.IsHostMove() ? m.profile.Velocity() : 0.0f;
+    
+    m.target_velocity = velocity;
+    m.target_distance = fabsf(dist_mm);
+    m.SetMotion(filament_motion_enum::position_control);
+    m.accumulated_distance = 0;
+    m.position_ref = 0;
+    m.position_tolerance = tolerance_mm < 0 ? POSITION_TOLERANCE_DEFAULT : tolerance_mm;
+    m.settle_time = 0;
+    m.hold_time = 0;
+    m.PID_position.Clear();
+    m.profile.Start(m.target_distance, velocity, accel < 0 ? move_accel : accel,
+                    jerk < 0 ? move_jerk : jerk, v_start);
+}
+
+// Outer loop of a position move. The profile drives a reference trajectory
+// rather than the lane itself, so slip or coasting shows up as tracking
+// error and is corrected while moving and after the reference has stopped.
+// Returns the speed setpoint, or stops the lane once the move is finished.
+float MMU_Logic::RunPositionControl(int CHx, float time_E) {
+    MotorChannel &m = motors[CHx];
+    float target = m.target_velocity < 0 ? -m.target_distance : m.target_distance;
+    
+    float v_ref = 0;
+    if (m.position_ref != target) {
+        v_ref = m.profile.Step(fabsf(m.position_ref), time_E);
+        m.position_ref += v_ref * time_E;
+        if (fabsf(m.position_ref) >= m.target_distance) {
+            m.position_ref = target;
+            v_ref = 0;
+        }
+    }
+    
+    float limit = fabsf(m.target_velocity);
+    if (limit < MotionProfile::CREEP_SPEED) limit = MotionProfile::CREEP_SPEED;
+    float speed_set = v_ref + m.PID_position.Calculate(m.position_ref - m.accumulated_distance, time_E);
+    if (speed_set > limit) speed_set = limit;
+    else if (speed_set < -limit) speed_set = -limit;
+    
+    if (m.position_ref != target) return speed_set;
+    
+    float error = target - m.accumulated_distance;
+    m.hold_time += time_E;
+    if (fabsf(error) <= m.position_tolerance && fabsf(speed_as5600[CHx]) < POSITION_SETTLE_SPEED) {
+        m.settle_time += time_E;
+    } else {
+        m.settle_time = 0;
+    }
+    
+    bool settled = m.settle_time * 1000.0f >= POSITION_SETTLE_MS;
+    if (settled || m.hold_time * 1000.0f >= POSITION_TIMEOUT_MS) {
+        m.SetMotion(filament_motion_enum::stop);
+        PushEvent(MMU_EventType::move_done, (uint8_t)(1 << CHx),
+                  (int32_t)(error * 1000.0f), settled ? 1 : 0);
+        AdvanceMoveQueue(CHx);
+        return 0;
+    }
+    return speed_set;
+}
+
+bool MMU_Logic::QueueMove(int lane, const MoveSegment& seg) {
+    if (lane < 0 || lane >= 4) return false;
+    MoveQueue &q = move_queue[lane];
+    if (q.count >= MOVE_QUEUE_DEPTH) return false;
+    q.seg[(q.head + q.count) % MOVE_QUEUE_DEPTH] = seg;
+    q.count++;
+    // Arrived right behind the running segment: let that one hand over at speed
+    if (q.running && q.count == 2 && !(q.seg[q.head].flags & MOVE_SEG_POSITION)) {
+        motors[lane].profile.SetEndVelocity(QueuedEndVelocity(lane));
+    }
+    return true;
+}
+
+void MMU_Logic::FlushMoveQueue(int lane) {
+    if (lane < 0 || lane >= 4) return;
+    move_queue[lane].head = 0;
+    move_queue[lane].count = 0;
+    move_queue[lane].running = false;
+}
+
+// Speed the running segment may arrive with, so the next one takes over
+// without stopping. Only for an untimed velocity segment in the same direction.
+float MMU_Logic::QueuedEndVelocity(int lane) const {
+    const MoveQueue &q = move_queue[lane];
+    if (q.count < 2) return 0;
+    const MoveSegment &cur = q.seg[q.head];
+    const MoveSegment &next = q.seg[(q.head + 1) % MOVE_QUEUE_DEPTH];
+    if ((cur.flags | next.flags) & MOVE_SEG_POSITION) return 0;
+    if (next.flags & MOVE_SEG_TIMED) return 0;
+    bool cur_rev = cur.dist_mm < 0 || cur.speed < 0;
+    bool next_rev = next.dist_mm < 0 || next.speed < 0;
+    if (cur_rev != next_rev) return 0;
+    return fminf(fabsf(cur.speed), fabsf(next.speed));
+}
+
+bool MMU_Logic::StartQueuedMove(int lane, uint64_t now) {
+    MoveQueue &q = move_queue[lane];
+    const MoveSegment &seg = q.seg[q.head];
+    if ((seg.flags & MOVE_SEG_TIMED) && (int32_t)((uint32_t)now - seg.start_ms) < 0) return false;
+    
+    q.running = true;
+    if (seg.flags & MOVE_SEG_POSITION) {
+        StartPositionMove(lane, seg.dist_mm, seg.speed, seg.accel, seg.jerk, seg.tolerance_mm);
+    } else {
+        StartVelocityMove(lane, seg.dist_mm, seg.speed, seg.accel, seg.jerk);
+        motors[lane].profile.SetEndVelocity(QueuedEndVelocity(lane));
+    }
+    return true;
+}
+
+// Start queued segments on lanes that are not already running a host move
+void MMU_Logic::ServiceMoveQueues(uint64_t now) {
+    for (int i = 0; i < 4; i++) {
+        const MoveQueue &q = move_queue[i];
+        if (q.running || q.count == 0 || motors[i].IsHostMove()) continue;
+        StartQueuedMove(i, now);
+    }
+}
+
+// Called when a host move finishes. Retires the running queued segment
+// and starts the next one if it is due; false if the lane should stop.
+bool MMU_Logic::AdvanceMoveQueue(int lane) {
+    MoveQueue &q = move_queue[lane];
+    if (!q.running) return false;
+    uint16_t tag = q.seg[q.head].tag;
+    q.head = (q.head + 1) % MOVE_QUEUE_DEPTH;
+    q.count--;
+    q.running = false;
+    PushEvent(MMU_EventType::segment_done, (uint8_t)(1 << lane), tag, q.count);
+    if (q.count == 0) return false;
+    return StartQueuedMove(lane, get_time64());
+}
+
+// A lane given a new motion by the host leaves its queue and any group
+void MMU_Logic::ReleaseLane(int lane) {
+    FlushMoveQueue(lane);
+    group_armed &= ~(1 << lane);
+    group_running &= ~(1 << lane);
+}
+
+bool MMU_Logic::StartMoveGroup(const MoveGroup& group) {
+    if (group_active) return false;
+    uint8_t mask = 0;
+    for (int i = 0; i < 4; i++) {
+        if (group.dist_mm[i] != 0) mask |= (1 << i);
+    }
+    if (!mask) return false;
+    
+    move_group = group;
+    for (int i = 0; i < 4; i++) {
+        if (mask & (1 << i)) FlushMoveQueue(i);
+    }
+    group_active = true;
+    group_started = false;
+    group_armed = mask;
+    group_running = 0;
+    group_finished = 0;
+    return true;
+}
+
+// Start all armed lanes on the same tick once due, then watch them finish
+void MMU_Logic::ServiceMoveGroup(uint64_t now) {
+    if (!group_active) return;
+    const MoveGroup &g = move_group;
+    
+    if (group_armed) {
+        if ((g.flags & MOVE_SEG_TIMED) && (int32_t)((uint32_t)now - g.start_ms) < 0) return;
+        for (int i = 0; i < 4; i++) {
+            if (!(group_armed & (1 << i))) continue;
+            if (g.flags & MOVE_SEG_POSITION) {
+                StartPositionMove(i, g.dist_mm[i], g.speed[i], g.accel, g.jerk, g.tolerance_mm);
+            } else {
+                StartVelocityMove(i, g.dist_mm[i], g.speed[i], g.accel, g.jerk);
+            }
+        }
+        group_running = group_armed;
+        group_armed = 0;
+        group_started = true;
+        group_start_time = now;
+        return;
+    }
+    
+    for (int i = 0; i < 4; i++) {
+        if ((group_running & (1 << i)) && !motors[i].IsHostMove()) {
+            group_running &= ~(1 << i);
+            group_finished |= (1 << i);
+        }
+    }
+    if (group_running) return;
+    
+    group_active = false;
+    PushEvent(MMU_EventType::group_done, group_finished, g.tag,
+              group_started ? (int32_t)(now - group_start_time) : -1);
+}
+
+void MMU_Logic::SetExtruderVelocity(float mm_s) {
+    if (mm_s > FEEDFORWARD_MAX_SPEED) mm_s = FEEDFORWARD_MAX_SPEED;
+    else if (mm_s < -FEEDFORWARD_MAX_SPEED) mm_s = -FEEDFORWARD_MAX_SPEED;
+    extruder_velocity = mm_s;
+    extruder_velocity_time = get_time64();
+}
+
+// Outer AutoFeed loop: buffer offset beyond the deadband -> speed correction.
+// Low voltage means the buffer is draining, so the lane feeds faster.
+float MMU_Logic::RunBufferLoop(int CHx, float time_E) {
+    float db = control_gains.buffer_deadband;
+    float e = BUFFER_CENTRE_V - MC_PULL_stu_raw[CHx];
+    if (e > db) e -= db;
+    else if (e < -db) e += db;
+    else e = 0;
+    
+    float v = motors[CHx].PID_buffer.Calculate(e, time_E);
+    if (v > BUFFER_SPEED_MAX) v = BUFFER_SPEED_MAX;
+    else if (v < -BUFFER_SPEED_MAX) v = -BUFFER_SPEED_MAX;
+    return v;
+}
+
+void MMU_Logic::SetObserverBandwidth(float hz) {
+    if (hz < 0) hz = 0;
+    if (hz > OBSERVER_BW_MAX_HZ) hz = OBSERVER_BW_MAX_HZ;
+    observer_bw_hz = hz;
+}
+
+bool MMU_Logic::SetControlGains(const ControlGains& gains) {
+    if (!ControlGainsValid(gains)) return false;
+    control_gains = gains;
+    for (int i = 0; i < 4; i++) {
+        motors[i].PID_buffer.SetGains(gains.buffer_kp, gains.buffer_ki, 0);
+        motors[i].PID_speed.SetGains(gains.speed_kp, gains.speed_ki, 0);
+    }
+    return true;
+}
+
+// Feedforward PWM for @p speed, or 0 if that direction is not learned.
+// Feeding takes PWM of sign -dir (see the speed PID above).
+float MMU_Logic::MotorModelPWM(int CHx, float speed) {
+    if (fabsf(speed) < MODEL_MIN_SPEED) return 0;
+    const MotorModelDir &md = motor_model[CHx].dir[speed > 0 ? 0 : 1];
+    if (md.slope <= 0) return 0;
+    float pwm = md.pwm0 + md.slope * fabsf(speed);
+    return speed > 0 ? -motors[CHx].dir * pwm : motors[CHx].dir * pwm;
+}
+
+// Collect (|v|, |PWM|) pairs while the lane holds its setpoint under power,
+// and refit every MODEL_REFIT_SAMPLES. Saturated, braking and transient
+// ticks are skipped since they do not reflect the steady-state curve.
+void MMU_Logic::LearnMotorModel(int CHx, float speed_set, float speed, float pwm) {
+    if (fabsf(speed) < MODEL_MIN_SPEED || fabsf(pwm) >= 1000) return;
+    if ((speed > 0) != (speed_set > 0)) return;
+    if (fabsf(speed - speed_set) > 0.1f * fabsf(speed_set) + 2.0f) return;
+    float drive = speed > 0 ? -motors[CHx].dir * pwm : motors[CHx].dir * pwm;
+    if (drive <= 0) return;
+    
+    int d = speed > 0 ? 0 : 1;
+    MotorModelDir &md = motor_model[CHx].dir[d];
+    float v = fabsf(speed);
+    md.s0 = md.s0 * MODEL_DECAY + 1.0f;
+    md.sv = md.sv * MODEL_DECAY + v;
+    md.sp = md.sp * MODEL_DECAY + drive;
+    md.svv = md.svv * MODEL_DECAY + v * v;
+    md.svp = md.svp * MODEL_DECAY + v * drive;
+    if (++md.pending >= MODEL_REFIT_SAMPLES) {
+        md.pending = 0;
+        RefitMotorModel(CHx, d);
+    }
+}
+
+void MMU_Logic::RefitMotorModel(int CHx, int d) {
+    MotorModelDir &md = motor_model[CHx].dir[d];
+    if (md.s0 < MODEL_MIN_WEIGHT) return;
+    float mean_v = md.sv / md.s0;
+    float var_v = md.svv / md.s0 - mean_v * mean_v;
+    if (var_v < MODEL_MIN_SPREAD * MODEL_MIN_SPREAD) return;
+    
+    float slope = (md.svp / md.s0 - mean_v * md.sp / md.s0) / var_v;
+    float pwm0 = md.sp / md.s0 - slope * mean_v;
+    if (slope <= 0 || slope > 50.0f || pwm0 < 0 || pwm0 > 900.0f) return;
+    md.slope = slope;
+    md.pwm0 = pwm0;
+    
+    // Persist once the curve has moved noticeably from the saved one,
+    // rate-limited so continuous learning does not wear the flash
+    float saved = model_saved.pwm0[CHx][d] + model_saved.slope_x100[CHx][d] * 0.5f;
+    float now_pwm = pwm0 + slope * 50.0f;
+    uint64_t now = _hal->GetTimeMS();
+    if (fabsf(now_pwm - saved) > MODEL_SAVE_PWM &&
+        (model_save_time == 0 || now - model_save_time >= MODEL_SAVE_INTERVAL_MS)) {
+        dirty_model = true;
+        SetNeedToSave();
+    }
+}
+
+void MMU_Logic::PackMotorModel(settings_motor_model_record& rec) const {
+    for (int i = 0; i < 4; i++) {
+        for (int d = 0; d < 2; d++) {
+            const MotorModelDir &md = motor_model[i].dir[d];
+            bool learned = md.slope > 0;
+            rec.pwm0[i][d] = learned ? (uint16_t)(md.pwm0 + 0.5f) : 0;
+            rec.slope_x100[i][d] = learned ? (uint16_t)(md.slope * 100.0f + 0.5f) : 0;
+        }
+    }
+}
+
+void MMU_Logic::ResetMotorModel(int lane) {
+    for (int i = 0; i < 4; i++) {
+        if (lane >= 0 && lane != i) continue;
+        memset(&motor_model[i], 0, sizeof(MotorModel));
+    }
+    SaveMotorModel();
+}
+
+void MMU_Logic::SaveMotorModel() {
+    dirty_model = true;
+    SetNeedToSave();
+}
+
+void MMU_Logic::SaveControlGains() {
+    dirty_gains = true;
+    SetNeedToSave();
+}
+
+bool MMU_Logic::StartAutotune(int lane, AutotuneLoop loop, bool apply, bool save) {
+    if (lane < 0 || lane >= 4 || IsAutotuneActive() || capture_active) return false;
+    MotorChannel &m = motors[lane];
+    if (MC_ONLINE_key_stu[lane] == 0) return false;     // Nothing for the encoder to follow
+    if (loop == AutotuneLoop::speed) {
+        // The speed test feeds freely, which a printing lane cannot do
+        if (m.motion == filament_motion_enum::pressure_ctrl_in_use) return false;
+    } else {
+        // The buffer test needs the buffer engaged and the extruder still
+        float v = MC_PULL_stu_raw[lane];
+        if (v < PULL_voltage_down || v > PULL_voltage_up) return false;
+        if (IsFeedforwardLive() && fabsf(extruder_velocity) > 0.1f) return false;
+    }
+    
+    ReleaseLane(lane);
+    memset(&tune, 0, sizeof(tune));
+    tune.lane = (uint8_t)lane;
+    tune.loop = loop;
+    tune.status = AutotuneStatus::running;
+    tune_apply = apply;
+    tune_save = save;
+    tune_relay = 1;
+    tune_periods = 0;
+    tune_prev_motion = m.motion;
+    tune_bias = fabsf(MotorModelPWM(lane, AUTOTUNE_SPEED));
+    if (tune_bias == 0) tune_bias = AUTOTUNE_PWM_BIAS;
+    if (tune_bias > 1000.0f - AUTOTUNE_PWM_STEP) tune_bias = 1000.0f - AUTOTUNE_PWM_STEP;
+    tune_max = -1e9f;
+    tune_min = 1e9f;
+    tune_amp_sum = 0;
+    tune_period_sum = 0;
+    tune_travel = 0;
+    tune_start_time = _hal->GetTimeMS();
+    tune_period_start = tune_start_time;
+    m.SetMotion(filament_motion_enum::autotune);
+    return true;
+}
+
+// Relay experiment. The relay flips on the measured error with hysteresis
+// h and settles into a limit cycle of amplitude a; by the describing
+// function, the loop then has the ultimate gain Ku = 4d / (pi*sqrt(a^2 - h^2))
+// for relay amplitude d, oscillating at the ultimate period Tu.
+// Speed test: PWM relay around tune_bias, measuring lane speed.
+// Buffer test: speed setpoint relay with PID_speed inside, measuring the
+// buffer voltage (feeding fills the buffer, raising it).
+// Returns the PWM for the lane.
+float MMU_Logic::RunAutotune(int CHx, float time_E) {
+    MotorChannel &m = motors[CHx];
+    bool speed = tune.loop == AutotuneLoop::speed;
+    float y = speed ? speed_as5600[CHx] : MC_PULL_stu_raw[CHx];
+    float e = (speed ? AUTOTUNE_SPEED : BUFFER_CENTRE_V) - y;
+    float h = speed ? AUTOTUNE_SPEED_HYST : AUTOTUNE_BUFFER_HYST;
+    
+    if (y > tune_max) tune_max = y;
+    if (y < tune_min) tune_min = y;
+    if (tune_relay > 0 && e < -h) {
+        tune_relay = -1;
+    } else if (tune_relay < 0 && e > h) {
+        // A period ends on each upward switch. The first one only
+        // measures the run-up from the start.
+        tune_relay = 1;
+        uint64_t now = _hal->GetTimeMS();
+        if (tune_periods++ > AUTOTUNE_SKIP_CYCLES) {
+            tune_amp_sum += 0.5f * (tune_max - tune_min);
+            tune_period_sum += (now - tune_period_start) / 1000.0f;
+            if (++tune.cycles >= AUTOTUNE_CYCLES) {
+                FinishAutotune(AutotuneStatus::ok);
+                return 0;
+            }
+        }
+        tune_period_start = now;
+        tune_max = y;
+        tune_min = y;
+    }
+    
+    if (speed) {
+        tune_travel += dist_as5600[CHx];
+        if (fabsf(tune_travel) > AUTOTUNE_MAX_TRAVEL) {
+            FinishAutotune(AutotuneStatus::no_cycle);
+            return 0;
+        }
+        return -m.dir * (tune_bias + tune_relay * AUTOTUNE_PWM_STEP);
+    }
+    
+    return SpeedLoopPWM(CHx, tune_relay * AUTOTUNE_BUFFER_SPEED, time_E);
+}
+
+// Abort when the lane was taken over (STOP, a new move, host timeout) or
+// lost its filament, or when no steady limit cycle formed in time
+void MMU_Logic::ServiceAutotune(uint64_t now) {
+    if (!IsAutotuneActive()) return;
+    int lane = tune.lane;
+    if (motors[lane].motion != filament_motion_enum::autotune || MC_ONLINE_key_stu[lane] == 0) {
+        FinishAutotune(AutotuneStatus::aborted);
+    } else if (now - tune_start_time >= AUTOTUNE_TIMEOUT_MS) {
+        FinishAutotune(AutotuneStatus::no_cycle);
+    }
+}
+
+void MMU_Logic::FinishAutotune(AutotuneStatus status) {
+    int lane = tune.lane;
+    MotorChannel &m = motors[lane];
+    bool speed = tune.loop == AutotuneLoop::speed;
+    
+    if (status == AutotuneStatus::ok) {
+        float d = speed ? AUTOTUNE_PWM_STEP : AUTOTUNE_BUFFER_SPEED;
+        float h = speed ? AUTOTUNE_SPEED_HYST : AUTOTUNE_BUFFER_HYST;
+        tune.amplitude = tune_amp_sum / tune.cycles;
+        tune.tu = tune_period_sum / tune.cycles;
+        if (tune.amplitude <= h || tune.tu <= 0) {
+            status = AutotuneStatus::no_cycle;  // Relay chatter, not a limit cycle
+        } else {
+            tune.ku = 4.0f * d / ((float)AS5600_PI * sqrtf(tune.amplitude * tune.amplitude - h * h));
+            tune.kp = tune.ku / AUTOTUNE_KP_RATIO;
+            tune.ki = tune.kp / (AUTOTUNE_TI_RATIO * tune.tu);
+        }
+    }
+    tune.status = status;
+    
+    if (status == AutotuneStatus::ok && tune_apply) {
+        ControlGains g = control_gains;
+        if (speed) {
+            g.speed_kp = tune.kp;
+            g.speed_ki = tune.ki;
+        } else {
+            g.buffer_kp = tune.kp;
+            g.buffer_ki = tune.ki;
+        }
+        tune.applied = SetControlGains(g);
+        if (tune.applied && tune_save) {
+            SaveControlGains();
+            tune.saved = true;
+        }
+    }
+    
+    // Hand the lane back unless something else already took it over
+    bool resume = status != AutotuneStatus::aborted;
+    if (m.motion == filament_motion_enum::autotune) {
+        if (resume && speed && fabsf(tune_travel) > POSITION_TOLERANCE_DEFAULT) {
+            // Return the filament fed during the test
+            StartPositionMove(lane, -tune_travel, AUTOTUNE_SPEED, -1.0f, -1.0f, -1.0f);
+        } else if (resume && tune_prev_motion == filament_motion_enum::pressure_ctrl_in_use) {
+            m.SetMotion(filament_motion_enum::pressure_ctrl_in_use);
+        } else {
+            m.SetMotion(filament_motion_enum::stop);
+        }
+    }
+    PushEvent(MMU_EventType::autotune_done, (uint8_t)(1 << lane), (int32_t)status, (int32_t)tune.loop);
+}
+
+// PID_speed plus feedforward for @p speed_set, as RunMotorChannel applies it
+float MMU_Logic::SpeedLoopPWM(int CHx, float speed_set, float time_E) {
+    MotorChannel &m = motors[CHx];
+    float x = m.dir * m.PID_speed.Calculate(speed_as5600[CHx] - speed_set, time_E);
+    float x_ff = MotorModelPWM(CHx, speed_set);
+    if (x_ff != 0) x += x_ff;
+    else if (x > 10) x += m.pwm_zero;
+    else if (x < -10) x -= m.pwm_zero;
+    else x = 0;
+    if (x > 1000) x = 1000;
+    if (x < -1000) x = -1000;
+    return x;
+}
+
+// Statically allocated (zeroed .bss) rather than inside MMU_Logic, which
+// setup() creates with new: the link then accounts for it against RAM.
+// Only one capture runs at a time.
+static CaptureSample capture_buf[CAPTURE_SAMPLES];
+
+const CaptureSample* MMU_Logic::GetCaptureSamples() const {
+    return capture_buf;
+}
+
+bool MMU_Logic::StartCapture(const CaptureConfig& cfg) {
+    int lane = cfg.lane;
+    if (lane >= 4 || capture_active || IsAutotuneActive()) return false;
+    if (motors[lane].motion == filament_motion_enum::pressure_ctrl_in_use) return false;
+    
+    ReleaseLane(lane);
+    capture_cfg = cfg;
+    float limit = cfg.mode == CaptureMode::pwm ? 1000.0f : CAPTURE_MAX_SPEED;
+    if (capture_cfg.step > limit) capture_cfg.step = limit;
+    else if (capture_cfg.step < -limit) capture_cfg.step = -limit;
+    if (capture_cfg.every < 1) capture_cfg.every = 1;
+    if (capture_cfg.every > CAPTURE_EVERY_MAX) capture_cfg.every = CAPTURE_EVERY_MAX;
+    if (capture_cfg.pre_samples >= CAPTURE_SAMPLES) capture_cfg.pre_samples = CAPTURE_SAMPLES - 1;
+    capture_count = 0;
+    capture_tick = 0;
+    capture_travel = 0;
+    capture_period_dist = 0;
+    capture_period_time = 0;
+    capture_start_time = _hal->GetTimeMS();
+    capture_active = true;
+    motors[lane].SetMotion(filament_motion_enum::capture);
+    return true;
+}
+
+// Step experiment: zero drive for pre_samples, then the step (open-loop
+// PWM, or a velocity setpoint through the normal speed loop), recording
+// every n-th tick until the buffer is full. Returns the PWM for the lane.
+float MMU_Logic::RunCapture(int CHx, float time_E) {
+    MotorChannel &m = motors[CHx];
+    capture_travel += dist_as5600[CHx];
+    capture_period_dist += dist_as5600[CHx];
+    capture_period_time += time_E;
+    bool stepped = capture_count >= capture_cfg.pre_samples &&
+                   fabsf(capture_travel) < CAPTURE_MAX_TRAVEL;
+    float step = stepped ? capture_cfg.step : 0.0f;
+    float x = capture_cfg.mode == CaptureMode::pwm ? -m.dir * step : SpeedLoopPWM(CHx, step, time_E);
+    
+    if (capture_tick == 0) {
+        CaptureSample &s = capture_buf[capture_count];
+        // Unfiltered: the fit must not see the observer's own lag
+        float speed_x10 = capture_period_time > 0 ?
+                          capture_period_dist / capture_period_time * 10.0f : 0;
+        capture_period_dist = 0;
+        capture_period_time = 0;
+        if (speed_x10 > 32767.0f) speed_x10 = 32767.0f;
+        else if (speed_x10 < -32767.0f) speed_x10 = -32767.0f;
+        s.t_ms = (uint16_t)(_hal->GetTimeMS() - capture_start_time);
+        s.angle = (uint16_t)as5600_distance_save[CHx];
+        s.speed_x10 = (int16_t)speed_x10;
+        s.pressure_mv = (uint16_t)(MC_PULL_stu_raw[CHx] * 1000.0f);
+        s.pwm = (int16_t)(-m.dir * x);
+        if (++capture_count >= CAPTURE_SAMPLES) {
+            FinishCapture();
+            return 0;
+        }
+    }
+    if (++capture_tick >= capture_cfg.every) capture_tick = 0;
+    return x;
+}
+
+// End the capture early if the lane was taken over (STOP, a move, host timeout)
+void MMU_Logic::ServiceCapture() {
+    if (capture_active && motors[capture_cfg.lane].motion != filament_motion_enum::capture) {
+        FinishCapture();
+    }
+}
+
+void MMU_Logic::FinishCapture() {
+    MotorChannel &m = motors[capture_cfg.lane];
+    if (m.motion == filament_motion_enum::capture) m.SetMotion(filament_motion_enum::stop);
+    capture_active = false;
+    PushEvent(MMU_EventType::capture_done, (uint8_t)(1 << capture_cfg.lane), capture_count,
+              (int32_t)(_hal->GetTimeMS() - capture_start_time));
+}
+
+bool MMU_Logic::IsFeedforwardLive() {
+    return extruder_velocity_time != 0 &&
+           get_time64() - extruder_velocity_time < FEEDFORWARD_TIMEOUT_MS;
+}
+
+void MMU_Logic::SetMoveLimits(float accel, float jerk) {
+    move_accel = accel > 0 ? accel : 0;
+    move_jerk = jerk > 0 ? jerk : 0;
 }
 
 void MMU_Logic::StopAll() {
     for(int i=0; i<4; i++) {
+         ReleaseLane(i);
          motors[i].SetMotion(filament_motion_enum::stop);
          filament_now_position[i] = filament_idle;
     }
@@ -669,10 +1924,18 @@ void MMU_Logic::StopAll() {
 
 void MMU_Logic::SetCurrentFilamentIndex(int index) {
     if (index >= 0 && index < 4) {
-        data_save.BambuBus_now_filament_num = index;
+        SetGlobalSelection(index, data_save.filament_use_flag);
     }
 }
 
+void MMU_Logic::SetGlobalSelection(int tray, uint8_t use_flag) {
+    if (data_save.BambuBus_now_filament_num == tray && data_save.filament_use_flag == use_flag) return;
+    data_save.BambuBus_now_filament_num = tray;
+    data_save.filament_use_flag = use_flag;
+    dirty_global = true;
+    SetNeedToSave();
+}
+
 void MMU_Logic::SetAutoFeed(int lane, bool enable) {
     if(lane < 0 || lane >= 4) return;
     if (enable) {
@@ -683,6 +1946,54 @@ void MMU_Logic::SetAutoFeed(int lane, bool enable) {
     }
 }
 
+// Build the next snapshot in the back buffer, then flip it to the front.
+// ID/name are only re-sanitised for lanes whose metadata changed; all other
+// lanes carry the strings over from the current front buffer.
+void MMU_Logic::PublishStatus(uint64_t now) {
+    const StatusSnapshot &front = status_buf[status_front];
+    StatusSnapshot &back = status_buf[status_front ^ 1];
+    
+    back.seq = front.seq + 1;
+    back.time_ms = now;
+    back.sensors = GetSensorState();
+    back.active_lane = data_save.BambuBus_now_filament_num;
+    
+    for (int i = 0; i < 4; i++) {
+        const FilamentState &f = data_save.filament[i];
+        LaneSnapshot &l = back.lanes[i];
+        
+        l.present = (back.sensors & (1 << i)) != 0;
+        l.motion = (uint8_t)motors[i].motion;
+        l.motion_str = MotionName(motors[i].motion);
+        
+        float meters_f = f.meters;
+        if (!isfinite(meters_f)) meters_f = 0;
+        if (meters_f > 2000000000.0f) meters_f = 2000000000.0f;
+        if (meters_f < -2000000000.0f) meters_f = -2000000000.0f;
+        l.meters_int = (int32_t)meters_f;
+        int m_dec = (int)((meters_f - l.meters_int) * 100);
+        l.meters_dec = (uint8_t)(m_dec < 0 ? -m_dec : m_dec);
+        l.meters_neg = (meters_f < 0 && l.meters_int == 0);
+        
+        l.pressure_mv = f.pressure;
+        l.temp_min = f.temperature_min;
+        l.temp_max = f.temperature_max;
+        l.color[0] = f.color_R; l.color[1] = f.color_G;
+        l.color[2] = f.color_B; l.color[3] = f.color_A;
+        
+        if (status_meta_dirty & (1 << i)) {
+            SanitizeString(l.id, f.ID, sizeof(f.ID));
+            SanitizeString(l.name, f.name, sizeof(f.name));
+        } else {
+            memcpy(l.id, front.lanes[i].id, sizeof(l.id));
+            memcpy(l.name, front.lanes[i].name, sizeof(l.name));
+        }
+    }
+    status_meta_dirty = 0;
+    
+    status_front ^= 1;
+}
+
 uint16_t MMU_Logic::GetSensorState() {
      uint16_t state = 0;
      for(int i=0; i<4; i++) {
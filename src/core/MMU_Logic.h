@@ -5,6 +5,9 @@
 #include "MMU_Defs.h"
 #include "UnitState.h" // For FilamentState and FilamentInfo
 #include "I_MMU_Hardware.h"
+#include "SettingsLog.h"
+#include "OdometryJournal.h"
+#include "MotionProfile.h"
 
 // --- Internal Configuration Constants ---
 // (Could be moved to a config file)
@@ -13,6 +16,109 @@
 #define MOTOR_SPEED_SLOW_SEND 800
 #define MOTOR_SPEED_PULL 2000
 
+// Host liveness: velocity moves are stopped if no packet arrives for this long.
+// Default stays above the host's 10 s poll interval; the host tightens it via SET_CONFIG.
+#define HOST_TIMEOUT_DEFAULT_MS 15000
+#define HOST_TIMEOUT_MIN_MS 250
+
+// --- NVS Layout (offsets into I_MMU_Hardware NVS, NVS_PAGE_SIZE pages) ---
+#define NVS_ODOMETRY_OFFSET         0x0000  // Odometry journal, 1 page
+#define NVS_SETTINGS_LOG_OFFSET     0x1000  // Settings record log (A/B)
+#define SETTINGS_LOG_PAGES 2
+#define NVS_MOTION_CONTROL_OFFSET   0x3000  // Motion_control_save_struct (read only)
+#define NVS_LEGACY_SETTINGS_OFFSET  0x4000  // Pre-log flash_save_struct (migrated once)
+
+// How often lane movement is journaled
+#define ODO_JOURNAL_MM 50
+#define ODO_JOURNAL_MS 10000
+
+// Save debounce: write once edits have been quiet this long, but never
+// defer a pending save by more than SAVE_FORCE_MS.
+#define SAVE_QUIET_MS 500
+#define SAVE_FORCE_MS 5000
+
+// After a failed save, journal roll or flash write, new saves and rolls
+// wait SAVE_FORCE_MS, doubling per consecutive failure up to 16x, and stop
+// after NVS_RETRY_LIMIT failures so a bad page is not erased over and
+// over. A completed write clears the streak.
+#define NVS_RETRY_LIMIT 8
+
+// Host MOVE shaping defaults (SET_CONFIG move_accel / move_jerk).
+// Acceleration 0 restores the unshaped step to the commanded speed.
+#define MOVE_ACCEL_DEFAULT 400.0f   // mm/s^2
+#define MOVE_JERK_DEFAULT 0.0f      // mm/s^3, 0 = trapezoidal
+
+// Position moves (MOVE_POS): the outer loop turns tracking error into a
+// speed correction for PID_speed. A move ends once the lane has stayed
+// within tolerance and nearly still for POSITION_SETTLE_MS, or gives up
+// POSITION_TIMEOUT_MS after the reference reached the target.
+#define POSITION_KP 8.0f                    // (mm/s) per mm of error
+#define POSITION_TOLERANCE_DEFAULT 0.2f     // mm
+#define POSITION_SETTLE_SPEED 5.0f          // mm/s
+#define POSITION_SETTLE_MS 100
+#define POSITION_TIMEOUT_MS 1500
+
+// AutoFeed (pressure_ctrl_in_use) is a cascade: the buffer loop turns the
+// sensor's offset from BUFFER_CENTRE_V, beyond a deadband, into a speed
+// setpoint that PID_speed tracks. Gains are runtime-tunable (SET_CONFIG).
+#define BUFFER_CENTRE_V 1.675f
+#define BUFFER_KP_DEFAULT 150.0f        // (mm/s) per V
+#define BUFFER_KI_DEFAULT 50.0f         // (mm/s) per V*s
+#define BUFFER_DEADBAND_DEFAULT 0.025f  // V either side of the centre
+#define BUFFER_SPEED_MAX 60.0f          // mm/s, buffer loop output limit
+#define SPEED_KP_DEFAULT 2.0f
+#define SPEED_KI_DEFAULT 20.0f
+
+// Learned motor model: |PWM| = pwm0 + slope * |v| per lane and direction,
+// fitted from steady speed-loop operation and used as PWM feedforward so
+// the speed PID only corrects the residual. See MMU_Logic::LearnMotorModel.
+#define MODEL_MIN_SPEED 5.0f        // mm/s, slower samples are mostly stiction
+#define MODEL_DECAY 0.999f          // Per-sample forgetting factor
+#define MODEL_REFIT_SAMPLES 200
+#define MODEL_MIN_WEIGHT 100.0f     // Effective samples before a fit is used
+#define MODEL_MIN_SPREAD 8.0f       // mm/s, speed std dev needed for a slope
+#define MODEL_SAVE_PWM 15.0f        // Persist once the prediction at 50 mm/s moves this far
+#define MODEL_SAVE_INTERVAL_MS 600000
+
+// Extruder feedforward (EXTRUDER_VEL): while the host streams the extruder
+// velocity it is added to the AutoFeed speed setpoint, leaving the buffer
+// loop only the residual. The stream lapses after FEEDFORWARD_TIMEOUT_MS.
+#define FEEDFORWARD_TIMEOUT_MS 300
+#define FEEDFORWARD_MAX_SPEED 200.0f    // mm/s
+
+// Encoder velocity observer: an alpha-beta tracking loop on the unwrapped
+// angle, critically damped at the configured bandwidth (OBSERVER). It
+// replaces the per-tick finite difference, which is quantised to one
+// encoder tick per ms. Bandwidth 0 falls back to that raw difference.
+#define OBSERVER_BW_DEFAULT_HZ 20.0f
+#define OBSERVER_BW_MAX_HZ 100.0f
+#define OBSERVER_MAX_DT 0.05f           // s; longer gaps re-seed from the raw difference
+
+// Relay autotune (AUTOTUNE): a relay with hysteresis drives one loop of a
+// lane into a limit cycle, whose amplitude and period give the ultimate
+// gain and period. PI gains follow the Tyreus-Luyben rules, which trade
+// some speed for much less overshoot than Ziegler-Nichols.
+#define AUTOTUNE_SPEED 40.0f            // mm/s, speed test setpoint
+#define AUTOTUNE_SPEED_HYST 2.0f        // mm/s
+#define AUTOTUNE_PWM_BIAS 600.0f        // Relay centre until a motor model is learned
+#define AUTOTUNE_PWM_STEP 250.0f        // Relay amplitude, PWM
+#define AUTOTUNE_BUFFER_SPEED 15.0f     // Relay amplitude, mm/s
+#define AUTOTUNE_BUFFER_HYST 0.01f      // V
+#define AUTOTUNE_SKIP_CYCLES 2          // Settling periods before measuring
+#define AUTOTUNE_CYCLES 4               // Periods averaged
+#define AUTOTUNE_MAX_TRAVEL 200.0f      // mm, speed test
+#define AUTOTUNE_TIMEOUT_MS 20000
+#define AUTOTUNE_KP_RATIO 3.2f          // Kp = Ku / 3.2
+#define AUTOTUNE_TI_RATIO 2.2f          // Ti = 2.2 * Tu
+
+// Step-response capture (CAPTURE): a lane runs an open-loop PWM step or a
+// closed-loop velocity step while every n-th control tick is recorded to
+// RAM, for offline system identification (Klipper/bmcu_sysid.py).
+#define CAPTURE_SAMPLES 192
+#define CAPTURE_EVERY_MAX 50            // Ticks per sample
+#define CAPTURE_MAX_SPEED 200.0f        // mm/s, velocity steps
+#define CAPTURE_MAX_TRAVEL 300.0f       // mm; the step is dropped beyond this, recording goes on
+
 // --- PID Helper Class ---
 class MOTOR_PID
 {
@@ -23,8 +129,13 @@ public:
     MOTOR_PID() {}
     
     void Init(float P_set, float I_set, float D_set) { P = P_set; I = I_set; D = D_set; I_save = 0; E_last = 0; }
+    void SetGains(float P_set, float I_set, float D_set) { P = P_set; I = I_set; D = D_set; }
     void Clear() { I_save = 0; E_last = 0; }
     
+    // Integrator state, carried across warm restarts
+    float Integral() const { return I_save; }
+    void SetIntegral(float v) { I_save = v; E_last = 0; }
+    
     float Calculate(float E, float time_E) {
         I_save += I * E * time_E;
         if (I_save > pid_range) I_save = pid_range;
@@ -50,10 +161,99 @@ enum class filament_motion_enum
     pressure_ctrl_idle,
     pressure_ctrl_in_use, 
     pressure_ctrl_on_use,
-    velocity_control
+    velocity_control,
+    position_control,
+    autotune,
+    capture
+};
+
+struct ControlGains {
+    float buffer_kp;
+    float buffer_ki;
+    float buffer_deadband;      // V
+    float speed_kp;
+    float speed_ki;
 };
 
-enum class pressure_control_enum { less_pressure, all, over_pressure };
+enum class AutotuneLoop : uint8_t { speed, buffer };
+enum class AutotuneStatus : uint8_t { none, ok, running, no_cycle, aborted };
+
+struct AutotuneResult {
+    uint8_t lane;
+    AutotuneLoop loop;
+    AutotuneStatus status;
+    uint8_t cycles;             // Periods measured
+    bool applied;
+    bool saved;
+    float amplitude;            // Half peak-to-peak: mm/s (speed) or V (buffer)
+    float ku;                   // Ultimate gain
+    float tu;                   // Ultimate period, s
+    float kp;
+    float ki;
+};
+
+enum class CaptureMode : uint8_t { pwm, velocity };
+
+struct CaptureConfig {
+    uint8_t lane;
+    CaptureMode mode;
+    uint8_t every;              // Control ticks per sample (1 = every tick)
+    uint16_t pre_samples;       // Samples recorded before the step
+    float step;                 // PWM or mm/s; + feeds
+};
+
+// One control tick, streamed to the host as raw little-endian bytes
+struct CaptureSample {
+    uint16_t t_ms;              // Since the capture started
+    uint16_t angle;             // Raw AS5600 angle, 0-4095
+    int16_t speed_x10;          // mm/s x10, + = feed; raw encoder travel over
+                                // the sample period, not the observer output
+    uint16_t pressure_mv;
+    int16_t pwm;                // Applied drive, + = feed
+};
+static_assert(sizeof(CaptureSample) == 10, "CaptureSample is part of the CAPTURE_READ format");
+
+// --- Host Move Queue ---
+// Segments queued per lane run back-to-back without waiting on the host.
+// A velocity segment hands over at speed to an immediately following
+// velocity segment in the same direction; anything else starts from rest.
+#define MOVE_QUEUE_DEPTH 6
+
+enum : uint8_t {
+    MOVE_SEG_POSITION = 0x01,   // Closed-loop segment (see MoveToPosition)
+    MOVE_SEG_TIMED    = 0x02,   // Hold until start_ms
+};
+
+struct MoveSegment {
+    float dist_mm;              // Signed, non-zero
+    float speed;                // mm/s
+    float accel;                // < 0: configured limit
+    float jerk;                 // < 0: configured limit
+    float tolerance_mm;         // Position segments, < 0: default
+    uint32_t start_ms;          // Logic clock (low 32 bits), MOVE_SEG_TIMED only
+    uint16_t tag;               // Echoed in the segment_done event
+    uint8_t flags;              // MOVE_SEG_*
+};
+
+struct MoveQueue {
+    MoveSegment seg[MOVE_QUEUE_DEPTH];
+    uint8_t head;
+    uint8_t count;              // Including the running segment
+    bool running;               // seg[head] is executing
+};
+
+// One move per lane, all started on the same control tick. Uses the
+// MoveSegment fields and flags, with per-lane distance and speed.
+struct MoveGroup {
+    float dist_mm[4];           // Signed; 0 = lane not in the group
+    float speed[4];
+    float accel;
+    float jerk;
+    float tolerance_mm;
+    uint32_t start_ms;
+    uint16_t tag;
+    uint8_t flags;              // MOVE_SEG_*
+};
 
 // --- Motor Channel Class ---
 class MotorChannel {
@@ -62,38 +262,51 @@ public:
     filament_motion_enum motion = filament_motion_enum::stop;
     uint64_t motor_stop_time = 0;
     MOTOR_PID PID_speed; 
-    MOTOR_PID PID_pressure; 
+    MOTOR_PID PID_pressure;     // Idle only: pressure -> PWM
+    MOTOR_PID PID_buffer;       // AutoFeed: pressure -> speed setpoint
     float pwm_zero = 500;
     float dir = 0; 
     float target_velocity = 0; 
     float target_distance = 0; 
-    float accumulated_distance = 0; 
+    float accumulated_distance = 0; // position_control: signed travel since the move started
+    MotionProfile profile;      // Setpoints for velocity_control moves, reference for position_control
+    
+    // position_control only (mm, signed, relative to the move start)
+    MOTOR_PID PID_position;
+    float position_ref = 0;     // Reference trajectory
+    float position_tolerance = POSITION_TOLERANCE_DEFAULT;
+    float settle_time = 0;      // Seconds within tolerance and below POSITION_SETTLE_SPEED
+    float hold_time = 0;        // Seconds since the reference reached the target
     
     MotorChannel() : CHx(0) {} // Default
-    MotorChannel(int ch) : CHx(ch) {
-        PID_speed.Init(2, 20, 0);
-        PID_pressure.Init(1500, 0, 0);
-    }
+    MotorChannel(int ch) { Init(ch); }
     
     void Init(int ch) {
         CHx = ch;
-        PID_speed.Init(2, 20, 0);
+        PID_speed.Init(SPEED_KP_DEFAULT, SPEED_KI_DEFAULT, 0);
         PID_pressure.Init(1500, 0, 0);
+        PID_buffer.Init(BUFFER_KP_DEFAULT, BUFFER_KI_DEFAULT, 0);
+        PID_position.Init(POSITION_KP, 0, 0);
+    }
+    
+    // Motions commanded by the host (moves, AUTOTUNE, CAPTURE), as opposed to AMS motions
+    bool IsHostMove() const {
+        return motion == filament_motion_enum::velocity_control ||
+               motion == filament_motion_enum::position_control ||
+               motion == filament_motion_enum::autotune ||
+               motion == filament_motion_enum::capture;
     }
 
     void SetMotion(filament_motion_enum m) {
         if (motion != m) {
             motion = m;
             PID_speed.Clear();
+            PID_buffer.Clear();
             accumulated_distance = 0; 
+            profile.Stop();
         }
     }
     
-    // Logic specific calculation - needs access to sensor data?
-    // In ControlLogic, GetXByPressure accessed global MC_PULL_stu_raw.
-    // If we move this to MMU_Logic, we should pass the sensor value in.
-    float CalculatePressureOutput(float current_pressure, float control_voltage, float time_E, pressure_control_enum control_type, float sign);
-    
     // Main Run requires logic context (sensors). 
     // We will separate logic: MMU_Logic updates Motors.
     // So MotorChannel is just state + PID. The "Run" logic should belong to MMU_Logic or passed dependencies.
@@ -121,12 +334,185 @@ struct alignas(4) flash_save_struct
     uint32_t check = 0x40614061;
 };
 
+// --- Status Snapshot ---
+// Immutable view of one lane, published once per control tick.
+// Strings are already sanitised (printable ASCII, NUL terminated) and
+// numeric fields are pre-split for integer-only formatting.
+struct LaneSnapshot {
+    bool present;
+    uint8_t motion;             // filament_motion_enum value
+    const char* motion_str;     // Protocol name ("Idle", "Feed", ...)
+    bool meters_neg;            // Sign for values between -1.0 and 0.0
+    int32_t meters_int;
+    uint8_t meters_dec;         // Hundredths, always positive
+    uint16_t pressure_mv;
+    char id[9];
+    char name[21];
+    uint16_t temp_min;
+    uint16_t temp_max;
+    uint8_t color[4];           // R, G, B, A
+};
+
+struct StatusSnapshot {
+    uint32_t seq;               // Incremented on every publish
+    uint64_t time_ms;           // Control tick time of this snapshot
+    uint16_t sensors;           // Presence bitmask (bit i = lane i)
+    int active_lane;
+    LaneSnapshot lanes[4];
+};
+
+// --- Settings Log Records ---
+// Key high nibble = record type, low nibble = lane (0 for global records).
+enum SettingsKey : uint8_t {
+    SETTINGS_KEY_LANE_INFO   = 0x10,  // FilamentInfo
+    SETTINGS_KEY_LANE_METERS = 0x20,  // float meters
+    SETTINGS_KEY_GLOBAL      = 0x30,  // settings_global_record
+    SETTINGS_KEY_ODOMETRY    = 0x40,  // settings_odometry_record
+    SETTINGS_KEY_WEAR        = 0x50,  // settings_wear_record
+    SETTINGS_KEY_MOTOR_MODEL = 0x60,  // settings_motor_model_record
+    SETTINGS_KEY_GAINS       = 0x70,  // ControlGains, low nibble = SETTINGS_GAINS_VERSION
+};
+
+#define SETTINGS_GAINS_VERSION 1
+
+struct settings_global_record {
+    int32_t now_filament_num;
+    uint32_t boot_mode;
+    uint8_t filament_use_flag;
+    uint8_t reserved[3];
+};
+
+// Journal position already folded into the persisted meters
+struct settings_odometry_record {
+    uint32_t epoch;
+    uint16_t offset;
+    uint16_t reserved;
+};
+
+// Lifetime erase count per NVS page owned by the logic (saturating)
+enum WearPage : uint8_t { WEAR_JOURNAL = 0, WEAR_LOG_A, WEAR_LOG_B, WEAR_PAGES };
+struct settings_wear_record {
+    uint16_t erases[WEAR_PAGES];
+    uint16_t reserved;
+};
+
+// Learned motor models, fixed point; 0 = direction not learned.
+// Index [lane][0 = feed, 1 = retract].
+struct settings_motor_model_record {
+    uint16_t pwm0[4][2];
+    uint16_t slope_x100[4][2];  // PWM per mm/s, x100
+};
+
+// Save policy counters since boot (or the last ResetFlashStats())
+struct SaveStats {
+    uint32_t saves;             // Successful SaveSettings() calls
+    uint32_t quiet_saves;       // Attempts after SAVE_QUIET_MS of no edits
+    uint32_t forced_saves;      // Attempts forced by SAVE_FORCE_MS while edits kept coming
+    uint32_t compactions;       // Saves that started a fresh log page
+    uint32_t journal_rolls;
+    uint32_t failures;          // Saves that could not be queued, plus NVS errors
+    uint32_t delay_ms_max;      // Longest first-edit-to-save delay
+};
+
+struct FlashStats {
+    SaveStats save;
+    settings_wear_record wear;
+    NVSStats nvs;
+    uint16_t log_free;          // Bytes left in the active settings page
+    uint16_t journal_free;      // Odometry records left before a roll
+    uint32_t log_generation;
+    uint8_t log_rejected;       // Committed pages rejected at mount
+    uint8_t fail_streak;        // Consecutive NVS failures; saves stop at NVS_RETRY_LIMIT
+};
+
+// Per direction: the model in use plus the weighted least-squares sums
+// it is refitted from
+struct MotorModelDir {
+    float pwm0;
+    float slope;                // 0 = not learned
+    float s0, sv, sp, svv, svp; // Decayed sums of 1, v, p, v^2, v*p
+    uint16_t pending;           // Samples since the last refit
+};
+
+struct MotorModel {
+    MotorModelDir dir[2];       // 0 = feed, 1 = retract
+};
+
 struct Motion_control_save_struct {
     uint32_t check;
     int Motion_control_dir[4]; 
     uint8_t padding[64]; 
 };
 
+// --- Warm Restart State ---
+// Runtime state mirrored into retained RAM at the end of every tick and
+// restored by Init() after any reset other than power-on.
+#define WARM_STATE_MAGIC 0x4D524157  // "WARM"
+#define WARM_STATE_VERSION 1
+// A reset loop stops resuming motion after this many consecutive warm
+// restarts; the chain is cleared once the firmware has run stably.
+#define WARM_RESTART_MAX_RESUME 3
+#define WARM_RESTART_STABLE_MS 10000
+
+struct warm_lane_state {
+    float meters;               // Includes consumption not yet persisted
+    float last_total_distance;
+    float unload_start_meters;
+    int32_t unload_target_dist;
+    int32_t encoder_raw;        // Last AS5600 angle
+    int32_t odo_ticks;
+    float target_velocity;
+    float target_distance;
+    float accumulated_distance;
+    float pid_speed_i;
+    float pid_buffer_i;
+    uint8_t position;           // filament_now_position_enum
+    uint8_t motion;             // filament_motion_enum
+    uint8_t motion_set;         // AMS_filament_motion
+    uint8_t assist;             // Assist_send_filament
+};
+
+struct warm_state_block {
+    uint32_t magic;
+    uint16_t version;
+    uint16_t restarts;          // Consecutive warm restarts without a stable run
+    int32_t now_filament_num;
+    uint32_t host_timeout_ms;
+    uint8_t filament_use_flag;
+    uint8_t flags;              // WARM_FLAG_*
+    uint8_t dirty_info;
+    uint8_t dirty_meters;
+    warm_lane_state lanes[4];
+    uint32_t crc;               // CRC32 of everything above
+};
+
+enum : uint8_t {
+    WARM_FLAG_BACKING_OUT  = 0x01,
+    WARM_FLAG_PULL_OLD     = 0x02,
+    WARM_FLAG_NEED_SAVE    = 0x04,
+    WARM_FLAG_DIRTY_GLOBAL = 0x08,
+};
+
+// --- Asynchronous Events (Logic -> API) ---
+enum class MMU_EventType : uint8_t {
+    host_timeout,       // a = timeout ms, lane_mask = lanes stopped
+    host_reconnect,     // a = offline duration ms
+    hw_ready,           // a = uptime ms when all subsystems became ready
+    move_done,          // Position move finished: a = final error um, b = 1 if settled
+    segment_done,       // Queued segment finished: a = tag, b = segments left
+    group_done,         // Group finished: lane_mask = lanes that completed, a = tag,
+                        // b = ms from start to the last lane finishing (-1 = never started)
+    autotune_done,      // a = AutotuneStatus, b = AutotuneLoop; details in GetAutotuneResult()
+    capture_done,       // a = samples recorded, b = duration ms
+};
+
+struct MMU_Event {
+    MMU_EventType type;
+    uint8_t lane_mask;
+    int32_t a;
+    int32_t b;
+};
+
 // --- MMU Logic Class ---
 class MMU_Logic {
 public:
@@ -137,6 +523,23 @@ public:
     
     // Connectivity
     void UpdateConnectivity(bool online);
+    bool IsHostConnected() const { return is_connected; }
+    void SetHostTimeout(uint32_t ms);
+    uint32_t GetHostTimeout() const { return host_timeout_ms; }
+    
+    // Events queued for the API layer; returns false when empty
+    bool PopEvent(MMU_Event& ev);
+    
+    // Boot info: hardware bring-up, reset cause, and whether runtime state was resumed
+    bool IsHardwareReady() const { return hw_ready; }
+    ResetCause GetResetCause() { return _hal->GetResetCause(); }
+    bool IsWarmRestart() const { return warm_restarts != 0; }
+    uint16_t GetWarmRestarts() const { return warm_restarts; }
+    
+    // Crash capture (see I_MMU_Hardware::Trace)
+    void Trace(TraceEvent event, uint8_t arg = 0, uint16_t value = 0) { _hal->Trace(event, arg, value); }
+    const CrashReport* GetCrashReport() { return _hal->GetCrashReport(); }
+    void ClearCrashReport() { _hal->ClearCrashReport(); }
     
     // Actions
     void SetFilamentInfoAction(int id, const FilamentInfo& info, float meters = -1.0f);
@@ -146,19 +549,84 @@ public:
     void SetCurrentFilamentIndex(int index);
     
     // Klipper Primitives
-    void MoveAxis(int axis, float dist_mm, float speed);
+    // Distance-bounded (dist_mm != 0) or open-ended velocity move. Negative
+    // dist_mm or speed retracts. accel/jerk < 0 use the configured limits.
+    void MoveAxis(int axis, float dist_mm, float speed, float accel = -1.0f, float jerk = -1.0f);
+    // Closed-loop move by exactly dist_mm (signed), reported by a move_done
+    // event. tolerance_mm < 0 uses POSITION_TOLERANCE_DEFAULT.
+    void MoveToPosition(int axis, float dist_mm, float speed, float accel = -1.0f, float jerk = -1.0f,
+                        float tolerance_mm = -1.0f);
+    // Append a segment to a lane's move queue; false if the queue is full.
+    // MoveAxis / MoveToPosition / StopAll discard anything queued.
+    bool QueueMove(int lane, const MoveSegment& seg);
+    void FlushMoveQueue(int lane);
+    uint8_t GetQueuedMoves(int lane) const { return (lane >= 0 && lane < 4) ? move_queue[lane].count : 0; }
+    // Arm a group move; false if one is still in progress or no lane is set.
+    // Lanes keep their current motion until the group starts.
+    bool StartMoveGroup(const MoveGroup& group);
+    bool IsGroupActive() const { return group_active; }
+    void SetMoveLimits(float accel, float jerk);
+    
+    // Extruder feedforward: latest extruder velocity (mm/s, + = extruding)
+    void SetExtruderVelocity(float mm_s);
+    bool IsFeedforwardLive();
+    
+    // Learned motor models (see LearnMotorModel)
+    const MotorModel& GetMotorModel(int lane) const { return motor_model[lane & 3]; }
+    void ResetMotorModel(int lane);     // -1 = all lanes; persisted on the next save
+    void SaveMotorModel();
+    
+    // Encoder velocity observer bandwidth (Hz, 0 = raw finite difference)
+    void SetObserverBandwidth(float hz);
+    float GetObserverBandwidth() const { return observer_bw_hz; }
+    float GetLaneSpeed(int lane) const { return speed_as5600[lane & 3]; }
+    // Filtered minus measured position (mm): the observer's current lag
+    float GetObserverLag(int lane) const { return -observer_err[lane & 3]; }
+    
+    // Cascade gains for all lanes; loop state is kept. Gains persist only
+    // through SaveControlGains(), so host-sent values stay runtime tweaks.
+    // Fails, keeping the current gains, unless every field is finite and >= 0.
+    bool SetControlGains(const ControlGains& gains);
+    const ControlGains& GetControlGains() const { return control_gains; }
+    void SaveControlGains();
+    
+    // Relay autotune of one loop on @p lane (see RunAutotune). Fails if a
+    // test is running or the lane cannot take it. The outcome is reported
+    // by an autotune_done event; @p apply adopts the gains for all lanes
+    // and @p save also persists them.
+    bool StartAutotune(int lane, AutotuneLoop loop, bool apply, bool save);
+    bool IsAutotuneActive() const { return tune.status == AutotuneStatus::running; }
+    const AutotuneResult& GetAutotuneResult() const { return tune; }
+    
+    // Step-response capture (see RunCapture); false if a capture or
+    // autotune is running or the lane cannot take it. A new capture
+    // replaces the previous samples.
+    bool StartCapture(const CaptureConfig& cfg);
+    bool IsCaptureActive() const { return capture_active; }
+    const CaptureConfig& GetCaptureConfig() const { return capture_cfg; }
+    uint16_t GetCaptureCount() const { return capture_count; }
+    const CaptureSample* GetCaptureSamples() const;
+    float GetMoveAccel() const { return move_accel; }
+    float GetMoveJerk() const { return move_jerk; }
     void StopAll(); 
     uint16_t GetSensorState();  
     int GetLaneMotion(int lane);
     
+    // Last published status snapshot. Stays consistent until the next Run().
+    const StatusSnapshot& GetStatus() const { return status_buf[status_front]; }
+    
+    uint64_t GetTimeMS() { return _hal->GetTimeMS(); }
+    
     // Accessors (Replacement for UnitState)
     FilamentState& GetFilament(int index);
     int GetCurrentFilamentIndex();
     uint16_t GetDeviceType();
     
     // Persistence
-    void SaveSettings();
+    bool SaveSettings();
     void SetNeedToSave();
+    void GetFlashStats(FlashStats& out);
+    void ResetFlashStats();
 
 private:
     I_MMU_Hardware* _hal;
@@ -166,12 +634,21 @@ private:
     // State
     flash_save_struct data_save;
     Motion_control_save_struct mc_save;
+    SettingsLog settings_log;
+    OdometryJournal odo_journal;
+    settings_odometry_record odo_checkpoint;  // As held by the settings log
+    uint32_t odo_roll_epoch;    // Non-zero while folding into a new epoch
+    int32_t odo_ticks[4];       // Encoder ticks not yet journaled
+    uint64_t odo_flush_time;
     MotorChannel motors[4];
     
     filament_now_position_enum filament_now_position[4];
     
     // Sensor Cache
-    float speed_as5600[4];
+    float speed_as5600[4];      // Observer velocity (mm/s)
+    float dist_as5600[4];       // Measured travel over the last tick (mm)
+    float observer_err[4];      // Measured minus estimated position (mm)
+    float observer_bw_hz;
     float MC_PULL_stu_raw[4];
     int MC_PULL_stu[4];
     float MC_ONLINE_key_stu_raw[4];
@@ -186,19 +663,92 @@ private:
     int32_t unload_target_dist[4];
     float unload_start_meters[4];
     
+    // Double-buffered status: Run() fills the back buffer then flips.
+    StatusSnapshot status_buf[2];
+    volatile uint8_t status_front;
+    uint8_t status_meta_dirty;  // Bit per lane: ID/name need re-sanitising
+    
+    // Settings groups changed since they were last written to the log
+    uint8_t dirty_info;         // Bit per lane: FilamentInfo
+    uint8_t dirty_meters;       // Bit per lane: meters
+    bool dirty_global;          // Selection / use flag / boot mode
+    bool dirty_wear;
+    
+    settings_wear_record flash_wear;
+    SaveStats save_stats;
+    
+    warm_state_block* warm_state; // In retained RAM, nullptr if unsupported
+    uint16_t warm_restarts;     // Restart count at boot, as reported to the host
+    uint16_t warm_chain;        // Persisted count, cleared after WARM_RESTART_STABLE_MS
+    uint64_t warm_restore_time;
+    uint16_t traced_lane_state[4];  // Last traced position << 8 | motion
+    bool hw_ready;              // Control runs once all HAL subsystems are up
+    
+    float move_accel;           // MOVE shaping limits (see MotionProfile)
+    float move_jerk;
+    MoveQueue move_queue[4];
+    
+    float extruder_velocity;    // Host stream, see SetExtruderVelocity()
+    uint64_t extruder_velocity_time;
+    ControlGains control_gains;
+    MotorModel motor_model[4];
+    settings_motor_model_record model_saved;  // As held by the settings log
+    bool dirty_model;
+    uint64_t model_save_time;
+    bool dirty_gains;
+    AutotuneResult tune;        // Last or running experiment
+    bool tune_apply;
+    bool tune_save;
+    int8_t tune_relay;          // +1 drives the measurement up, -1 down
+    uint8_t tune_periods;       // Relay periods started, settling included
+    filament_motion_enum tune_prev_motion;
+    float tune_bias;            // Speed test: PWM the relay switches around
+    float tune_max;             // Extremes over the current period
+    float tune_min;
+    float tune_amp_sum;
+    float tune_period_sum;      // s
+    float tune_travel;          // mm, signed
+    uint64_t tune_start_time;
+    uint64_t tune_period_start;
+    CaptureConfig capture_cfg;
+    uint16_t capture_count;
+    uint8_t capture_tick;       // Ticks until the next sample
+    bool capture_active;
+    float capture_travel;       // mm, signed
+    float capture_period_dist;  // Raw travel (mm) and time (s) since the last sample
+    float capture_period_time;
+    uint64_t capture_start_time;
+    MoveGroup move_group;
+    bool group_active;
+    bool group_started;
+    uint8_t group_armed;        // Lanes waiting for the group start
+    uint8_t group_running;
+    uint8_t group_finished;     // Lanes whose group move completed
+    uint64_t group_start_time;
+    
     bool Bambubus_need_to_save;
-    uint64_t save_timer;
+    uint64_t save_timer;        // First unsaved change
+    uint64_t save_change_time;  // Latest unsaved change
+    uint8_t nvs_fail_streak;    // Consecutive NVS failures (see NVS_RETRY_LIMIT)
+    bool nvs_written;           // A save was queued and has not completed yet
+    uint64_t nvs_retry_time;    // No save or roll starts before this
     
     bool is_connected;
+    bool host_timed_out;
     uint64_t last_heartbeat_time;
+    uint64_t host_lost_time;
+    uint32_t host_timeout_ms;
+    
+    static constexpr uint8_t EVENT_QUEUE_SIZE = 8;
+    MMU_Event event_queue[EVENT_QUEUE_SIZE];
+    uint8_t event_head;
+    uint8_t event_tail;
     uint16_t device_type_addr;
     
     // Constants
     const bool is_two = true; // AMS Lite logic
     const float PULL_voltage_up = 1.85f;
     const float PULL_voltage_down = 1.45f;
-    const uint32_t use_flash_addr = 0x0800F000;
-    const uint32_t Motion_control_save_flash_addr = 0x0800E000;
 
     // Internal Methods
     void motor_motion_switch();
@@ -207,7 +757,46 @@ private:
     bool Prepare_For_filament_Pull_Back(float_t OUT_filament_meters);
     void UpdateLEDStatus(int channel);
     void RunMotorChannel(int channel, float time_E);
+    float RunPositionControl(int channel, float time_E);
+    float RunBufferLoop(int channel, float time_E);
+    float RunAutotune(int channel, float time_E);
+    void ServiceAutotune(uint64_t now);
+    void FinishAutotune(AutotuneStatus status);
+    float SpeedLoopPWM(int channel, float speed_set, float time_E);
+    float RunCapture(int channel, float time_E);
+    void ServiceCapture();
+    void FinishCapture();
+    float MotorModelPWM(int channel, float speed);
+    void LearnMotorModel(int channel, float speed_set, float speed, float pwm);
+    void RefitMotorModel(int channel, int dir);
+    void PackMotorModel(settings_motor_model_record& rec) const;
+    void StartVelocityMove(int axis, float dist_mm, float speed, float accel, float jerk);
+    void StartPositionMove(int axis, float dist_mm, float speed, float accel, float jerk, float tolerance_mm);
+    void ServiceMoveQueues(uint64_t now);
+    void ServiceMoveGroup(uint64_t now);
+    void ReleaseLane(int lane);
+    bool StartQueuedMove(int lane, uint64_t now);
+    bool AdvanceMoveQueue(int lane);
+    float QueuedEndVelocity(int lane) const;
     void LoadSettings();
+    void LoadDefaultSettings();
+    bool AppendChangedSettings(bool all);
+    void SetGlobalSelection(int tray, uint8_t use_flag);
+    bool CompactSettings();
+    void CountErase(uint8_t page);
+    static void ApplySettingsRecord(uint8_t key, const uint8_t* data, uint8_t len, void* ctx);
+    static void ApplyOdometryDelta(uint8_t lane, int16_t delta_ticks, void* ctx);
+    void JournalOdometry(uint64_t now);
+    void RollOdometry();
+    void NoteNVSFailure(uint64_t now);
+    bool NVSRetryAllowed(uint64_t now) const;
+    void PublishStatus(uint64_t now);
+    bool RestoreWarmState();
+    void SaveWarmState();
+    void TraceLaneStates();
+    void OnHardwareReady(uint64_t now);
+    void CheckHostLiveness(uint64_t now);
+    void PushEvent(MMU_EventType type, uint8_t lane_mask, int32_t a = 0, int32_t b = 0);
     
     // Helper
     uint64_t get_time64() { return _hal->GetTimeMS(); }
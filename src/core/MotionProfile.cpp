@@ -0,0 +1,74 @@
+/**
+ * @file MotionProfile.cpp
+ * @brief Velocity setpoint generator (see MotionProfile.h).
+ */
+#include "MotionProfile.h"
+#include <math.h>
+
+// Longer gaps between ticks (boot, blocking I/O) must not turn into a
+// single large velocity step
+#define PROFILE_MAX_DT 0.1f
+
+void MotionProfile::Start(float distance, float velocity, float accel, float jerk, float v_start) {
+    _distance = distance > 0 ? distance : 0;
+    _cruise = velocity;
+    _accel = accel > 0 ? accel : 0;
+    _jerk = jerk > 0 ? jerk : 0;
+    _v = _accel > 0 ? v_start : velocity;
+    _a = 0;
+    _v_end = 0;
+    _active = true;
+}
+
+// Highest speed from which the lane can still slow to the end velocity
+// within @p remaining mm
+float MotionProfile::StopSpeed(float remaining) const {
+    if (remaining <= 0) return _v_end;
+    if (_jerk > 0) {
+        float k = _accel * _accel / _jerk;
+        float c = _v_end * _v_end + _v_end * k + 2.0f * _accel * remaining;
+        return 0.5f * (sqrtf(k * k + 4.0f * c) - k);
+    }
+    return sqrtf(_v_end * _v_end + 2.0f * _accel * remaining);
+}
+
+float MotionProfile::Step(float travelled, float dt) {
+    if (!_active) return 0;
+    if (_accel <= 0) return _cruise;
+    if (dt > PROFILE_MAX_DT) dt = PROFILE_MAX_DT;
+    if (dt <= 0) return _v;
+
+    float target = _cruise;
+    if (_distance > 0) {
+        float cap = StopSpeed(_distance - travelled);
+        if (cap < CREEP_SPEED) cap = CREEP_SPEED; // The caller stops at the target
+        if (target > cap) target = cap;
+        else if (target < -cap) target = -cap;
+    }
+
+    float dv = target - _v;
+    if (_jerk > 0) {
+        // Largest acceleration that can still ramp back to zero by the time
+        // the setpoint reaches the target, then slew towards it at `jerk`
+        float a_max = sqrtf(2.0f * _jerk * fabsf(dv));
+        if (a_max > _accel) a_max = _accel;
+        float a_want = dv >= 0 ? a_max : -a_max;
+        float da = _jerk * dt;
+        if (a_want > _a + da) _a += da;
+        else if (a_want < _a - da) _a -= da;
+        else _a = a_want;
+
+        float v = _v + _a * dt;
+        if ((dv >= 0 && v >= target) || (dv < 0 && v <= target)) {
+            v = target;
+            _a = 0;
+        }
+        _v = v;
+    } else {
+        float dv_max = _accel * dt;
+        if (dv > dv_max) dv = dv_max;
+        else if (dv < -dv_max) dv = -dv_max;
+        _v += dv;
+    }
+    return _v;
+}
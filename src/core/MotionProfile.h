@@ -0,0 +1,65 @@
+/**
+ * @file MotionProfile.h
+ * @brief Acceleration/jerk-limited velocity setpoints for one lane.
+ *
+ * @details
+ * Step() is called once per control tick with the distance travelled so
+ * far (as measured by the encoder) and returns the velocity setpoint for
+ * the speed PID. The setpoint ramps towards the cruise speed at no more
+ * than `accel`, and is capped by the speed from which the lane can still
+ * stop in the remaining distance, so the deceleration phase is sized on
+ * the fly to land on the target even if the lane slipped on the way.
+ *
+ * With `jerk` > 0 the acceleration itself ramps (S-curve) and the
+ * stopping distance accounts for the ramp-down:
+ * @code
+ *   d_stop(v) = v^2 / (2a) + v * a / (2j)
+ * @endcode
+ * `accel` = 0 disables shaping: the setpoint jumps to the cruise speed.
+ *
+ * SetEndVelocity() lets a queued follow-on move take over at speed: the
+ * deceleration then aims for that speed at the target instead of rest.
+ */
+#pragma once
+
+#include <stdint.h>
+
+class MotionProfile {
+public:
+    /// Setpoint floor near the target so a move never stalls short of it (mm/s)
+    static constexpr float CREEP_SPEED = 2.0f;
+
+    MotionProfile() : _distance(0), _cruise(0), _accel(0), _jerk(0), _v(0), _a(0), _v_end(0), _active(false) {}
+
+    /**
+     * @param distance Target distance in mm (> 0), or 0 for an open-ended move.
+     * @param velocity Cruise velocity in mm/s; the sign gives the direction.
+     * @param accel    Acceleration limit in mm/s^2 (0 = unshaped).
+     * @param jerk     Jerk limit in mm/s^3 (0 = trapezoidal).
+     * @param v_start  Current setpoint, to blend from a move in progress.
+     */
+    void Start(float distance, float velocity, float accel, float jerk, float v_start = 0.0f);
+
+    /// Speed (mm/s, magnitude) to arrive at the target with; Start() resets it to 0.
+    void SetEndVelocity(float v_end) { _v_end = v_end > 0 ? v_end : 0; }
+
+    /// Velocity setpoint (mm/s) after @p dt seconds, given @p travelled mm so far.
+    float Step(float travelled, float dt);
+
+    void Stop() { _active = false; _v = 0; _a = 0; }
+
+    bool IsActive() const { return _active; }
+    float Velocity() const { return _v; }
+
+private:
+    float StopSpeed(float remaining) const;
+
+    float _distance;
+    float _cruise;
+    float _accel;
+    float _jerk;
+    float _v;           // Current setpoint (signed)
+    float _a;           // Current acceleration (signed, S-curve only)
+    float _v_end;
+    bool _active;
+};
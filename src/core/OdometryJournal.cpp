@@ -0,0 +1,76 @@
+/**
+ * @file OdometryJournal.cpp
+ * @brief Filament odometry journal (see OdometryJournal.h for layout).
+ */
+#include "OdometryJournal.h"
+
+// Torn records leave the delta half-word erased (0xFFFF); the check byte
+// then almost never matches, so such a record is skipped on replay.
+uint8_t OdometryJournal::Check(uint8_t tag, int16_t delta) {
+    uint16_t d = (uint16_t)delta;
+    return (uint8_t)~(tag ^ (d & 0xFF) ^ (d >> 8) ^ 0x5A);
+}
+
+OdometryJournal::OdometryJournal(I_MMU_Hardware* nvs, uint32_t page_addr)
+    : _nvs(nvs), _page_addr(page_addr), _epoch(0),
+      _write_offset(FIRST_OFFSET), _mounted(false) {}
+
+bool OdometryJournal::Mount() {
+    uint32_t hdr[2];
+    _mounted = _nvs->ReadNVS((uint8_t*)hdr, sizeof(hdr), _page_addr) && hdr[0] == PAGE_MAGIC;
+    _epoch = _mounted ? hdr[1] : 0;
+    _write_offset = NVS_PAGE_SIZE;
+    if (!_mounted) return false;
+
+    // Records are appended whole words, so the first erased word ends the log
+    uint32_t chunk[16];
+    for (uint16_t off = FIRST_OFFSET; off < NVS_PAGE_SIZE; off += sizeof(chunk)) {
+        uint16_t n = (uint16_t)(NVS_PAGE_SIZE - off);
+        if (n > sizeof(chunk)) n = sizeof(chunk);
+        if (!_nvs->ReadNVS((uint8_t*)chunk, n, _page_addr + off)) return true;  // Treat as full
+        for (uint16_t i = 0; i < n / 4; i++) {
+            if (chunk[i] == 0xFFFFFFFF) {
+                _write_offset = (uint16_t)(off + 4 * i);
+                return true;
+            }
+        }
+    }
+    return true;
+}
+
+void OdometryJournal::Replay(uint16_t offset, DeltaVisitor visit, void* ctx) const {
+    if (!_mounted) return;
+    if (offset < FIRST_OFFSET) offset = FIRST_OFFSET;
+    for (uint16_t off = offset; off < _write_offset; off += 4) {
+        uint8_t rec[4];
+        if (!_nvs->ReadNVS(rec, sizeof(rec), _page_addr + off)) return;
+        int16_t delta;
+        memcpy(&delta, rec + 2, sizeof(delta));
+        if ((rec[0] & 0xF0) != TAG || (rec[0] & 0x0F) >= 4) continue;
+        if (rec[1] != Check(rec[0], delta)) continue;
+        visit(rec[0] & 0x0F, delta, ctx);
+    }
+}
+
+bool OdometryJournal::Append(uint8_t lane, int16_t delta_ticks) {
+    if (!_mounted || lane >= 4 || _write_offset + 4 > NVS_PAGE_SIZE) return false;
+    uint8_t rec[4];
+    rec[0] = (uint8_t)(TAG | lane);
+    rec[1] = Check(rec[0], delta_ticks);
+    memcpy(rec + 2, &delta_ticks, sizeof(delta_ticks));
+    if (!_nvs->WriteNVS(rec, sizeof(rec), _page_addr + _write_offset)) return false;
+    _write_offset += 4;
+    return true;
+}
+
+bool OdometryJournal::Roll(uint32_t epoch) {
+    uint32_t hdr[2] = { PAGE_MAGIC, epoch };
+    if (!_nvs->EraseNVS(_page_addr) || !_nvs->WriteNVS((const uint8_t*)hdr, sizeof(hdr), _page_addr)) {
+        _mounted = false;
+        return false;
+    }
+    _epoch = epoch;
+    _write_offset = FIRST_OFFSET;
+    _mounted = true;
+    return true;
+}
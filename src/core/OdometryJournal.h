@@ -0,0 +1,65 @@
+/**
+ * @file OdometryJournal.h
+ * @brief Append-only filament odometry journal in a dedicated NVS page.
+ *
+ * @details
+ * Each record is one 32-bit word: lane, a check byte and a signed delta in
+ * encoder ticks, written with one WriteNVS() call. The page carries an epoch number; the settings
+ * store checkpoints (epoch, offset) whenever it persists absolute meters,
+ * so on boot only the records after that checkpoint are replayed.
+ *
+ * When the page fills, the owner folds the totals into the settings store
+ * with a checkpoint for the next epoch, then calls Roll(), which erases the
+ * page. NVS operations complete in order, so the fold always lands first.
+ *
+ * Page layout:
+ * @code
+ *   +0  { magic, epoch }
+ *   +8  { tag = 0x50 | lane, check, int16 delta_ticks } ... | erased (0xFF)
+ * @endcode
+ */
+#pragma once
+
+#include <stdint.h>
+#include <string.h>
+#include "I_MMU_Hardware.h"
+
+class OdometryJournal {
+public:
+    static constexpr uint16_t FIRST_OFFSET = 8;     ///< Offset of the first record
+    static constexpr int32_t MAX_DELTA = 32767;     ///< Per-record limit (ticks)
+
+    typedef void (*DeltaVisitor)(uint8_t lane, int16_t delta_ticks, void* ctx);
+
+    OdometryJournal(I_MMU_Hardware* nvs, uint32_t page_addr);
+
+    /// Read the page header and find the end of the journal.
+    /// @return false if the page holds no journal.
+    bool Mount();
+
+    /// Visit every valid record at or after @p offset, oldest first.
+    void Replay(uint16_t offset, DeltaVisitor visit, void* ctx) const;
+
+    /// Queue one record. @return false if full, unmounted or NVS is busy.
+    bool Append(uint8_t lane, int16_t delta_ticks);
+
+    /// Queue a page erase and a header for @p epoch.
+    bool Roll(uint32_t epoch);
+
+    bool IsMounted() const { return _mounted; }
+    uint32_t Epoch() const { return _epoch; }
+    uint16_t WriteOffset() const { return _write_offset; }
+    uint16_t FreeRecords() const { return (uint16_t)((NVS_PAGE_SIZE - _write_offset) / 4); }
+
+private:
+    static constexpr uint32_t PAGE_MAGIC = 0x4F444F4A;  // "JODO"
+    static constexpr uint8_t TAG = 0x50;
+
+    static uint8_t Check(uint8_t tag, int16_t delta);
+
+    I_MMU_Hardware* _nvs;
+    uint32_t _page_addr;
+    uint32_t _epoch;
+    uint16_t _write_offset;
+    bool _mounted;
+};
@@ -0,0 +1,163 @@
+/**
+ * @file SettingsLog.cpp
+ * @brief Append-only settings record log (see SettingsLog.h for layout).
+ *
+ * @details
+ * Appends queue a handful of half-words. A page erase is queued only when
+ * the active page fills, i.e. once per page rather than once per save.
+ */
+#include "SettingsLog.h"
+#include "Checksum.h"
+
+#define ERASED_HALFWORD 0xFFFF
+
+SettingsLog::SettingsLog(I_MMU_Hardware* nvs, uint32_t base, uint8_t page_count)
+    : _nvs(nvs), _base(base), _page_count(page_count < 2 ? 2 : page_count),
+      _page(0), _active(-1), _generation(0), _write_addr(base + sizeof(PageHeader)),
+      _snapshot_crc(0), _mounted(false), _pending(false), _rejected(0) {}
+
+uint32_t SettingsLog::PageAddr(uint8_t page) const {
+    return _base + (uint32_t)page * NVS_PAGE_SIZE;
+}
+
+bool SettingsLog::Mount() {
+    _mounted = false;
+    _pending = false;
+    _active = -1;
+    _rejected = 0;
+    for (uint8_t i = 0; i < _page_count; i++) {
+        PageHeader hdr;
+        if (!_nvs->ReadNVS((uint8_t*)&hdr, sizeof(hdr), PageAddr(i))) continue;
+        if (hdr.magic != PAGE_MAGIC || hdr.state != STATE_COMMITTED) continue;
+        if (!PageValid(PageAddr(i), hdr)) {
+            _rejected++;
+            continue;
+        }
+        if (!_mounted || (int32_t)(hdr.generation - _generation) > 0) {
+            _page = i;
+            _generation = hdr.generation;
+            _mounted = true;
+        }
+    }
+    if (_mounted) {
+        _active = (int8_t)_page;
+        _write_addr = ScanEnd(PageAddr(_page));
+    }
+    return _mounted;
+}
+
+// Committed and the snapshot written at compaction still matches its CRC32
+bool SettingsLog::PageValid(uint32_t page_addr, const PageHeader& hdr) const {
+    if (hdr.snapshot_len > NVS_PAGE_SIZE - sizeof(PageHeader)) return false;
+    uint8_t chunk[64];
+    uint32_t crc = 0xFFFFFFFF;
+    uint32_t addr = page_addr + sizeof(PageHeader);
+    for (uint16_t left = hdr.snapshot_len; left > 0; ) {
+        uint16_t n = left < sizeof(chunk) ? left : sizeof(chunk);
+        if (!_nvs->ReadNVS(chunk, n, addr)) return false;
+        crc = Crc32(crc, chunk, n);
+        addr += n;
+        left -= n;
+    }
+    return (crc ^ 0xFFFFFFFF) == hdr.snapshot_crc;
+}
+
+// Walk records to the first erased header. A malformed header means a torn
+// write we cannot append past, so the page is reported as full.
+uint32_t SettingsLog::ScanEnd(uint32_t page_addr) const {
+    uint32_t end = page_addr + NVS_PAGE_SIZE;
+    uint32_t addr = page_addr + sizeof(PageHeader);
+    while (addr + 2 <= end) {
+        uint16_t head;
+        if (!_nvs->ReadNVS((uint8_t*)&head, sizeof(head), addr)) return end;
+        if (head == ERASED_HALFWORD) return addr;
+        uint8_t len = (uint8_t)(head >> 8);
+        uint32_t next = addr + RecordSize(len);
+        if (len > MAX_PAYLOAD || next > end) return end;
+        addr = next;
+    }
+    return end;
+}
+
+void SettingsLog::Replay(RecordVisitor visit, void* ctx) const {
+    if (!_mounted) return;
+    uint16_t buf[RecordSize(MAX_PAYLOAD) / 2];
+    uint8_t* rec = (uint8_t*)buf;
+    uint32_t addr = PageAddr(_page) + sizeof(PageHeader);
+    while (addr < _write_addr) {
+        if (!_nvs->ReadNVS(rec, 2, addr)) return;
+        uint8_t key = rec[0];
+        uint8_t len = rec[1];
+        uint16_t size = RecordSize(len);
+        // Same guard as ScanEnd(): a torn header must not overrun buf
+        if (len > MAX_PAYLOAD || addr + size > _write_addr) return;
+        if (!_nvs->ReadNVS(rec + 2, (uint16_t)(size - 2), addr + 2)) return;
+        if (Crc16(0xFFFF, rec, (uint16_t)(size - 2)) == buf[size / 2 - 1]) {
+            visit(key, rec + 2, len, ctx);
+        }
+        addr += size;
+    }
+}
+
+bool SettingsLog::Append(uint8_t key, const void* data, uint8_t len) {
+    if (key == 0xFF || len > MAX_PAYLOAD) return false;
+    if (!_mounted && !_pending) return false;
+
+    uint16_t size = RecordSize(len);
+    if (_write_addr + size > PageAddr(_page) + NVS_PAGE_SIZE) return false;
+
+    uint16_t buf[RecordSize(MAX_PAYLOAD) / 2];
+    uint8_t* bytes = (uint8_t*)buf;
+    memset(buf, 0xFF, sizeof(buf));
+    bytes[0] = key;
+    bytes[1] = len;
+    memcpy(bytes + 2, data, len);
+    buf[size / 2 - 1] = Crc16(0xFFFF, bytes, (uint16_t)(size - 2));
+
+    if (!_nvs->WriteNVS(bytes, size, _write_addr)) return false;
+    if (_pending) _snapshot_crc = Crc32(_snapshot_crc, bytes, size);
+    _write_addr += size;
+    return true;
+}
+
+bool SettingsLog::BeginPage() {
+    // Never erase the last committed page, even when retrying a failed compaction
+    uint8_t next = _active >= 0 ? (uint8_t)((_active + 1) % _page_count) : 0;
+    uint32_t addr = PageAddr(next);
+    _mounted = false;  // Stays unmounted until a successful CommitPage()
+
+    // CRC, length and state stay erased until CommitPage()
+    PageHeader hdr;
+    hdr.magic = PAGE_MAGIC;
+    hdr.generation = _generation + 1;
+    if (!_nvs->EraseNVS(addr) ||
+        !_nvs->WriteNVS((const uint8_t*)&hdr, offsetof(PageHeader, snapshot_crc), addr)) return false;
+
+    _page = next;
+    _generation = hdr.generation;
+    _write_addr = addr + sizeof(PageHeader);
+    _snapshot_crc = 0xFFFFFFFF;
+    _pending = true;
+    return true;
+}
+
+bool SettingsLog::CommitPage() {
+    if (!_pending) return false;
+    uint32_t page_addr = PageAddr(_page);
+    PageHeader hdr;
+    hdr.snapshot_crc = _snapshot_crc ^ 0xFFFFFFFF;
+    hdr.snapshot_len = (uint16_t)(_write_addr - page_addr - sizeof(PageHeader));
+    hdr.state = STATE_COMMITTED;
+    // One contiguous program, ascending, so the state half-word lands last
+    if (!_nvs->WriteNVS((const uint8_t*)&hdr.snapshot_crc, sizeof(PageHeader) - offsetof(PageHeader, snapshot_crc),
+                        page_addr + offsetof(PageHeader, snapshot_crc))) return false;
+    _pending = false;
+    _mounted = true;
+    _active = (int8_t)_page;
+    return true;
+}
+
+void SettingsLog::Recover() {
+    Mount();
+    _mounted = false;
+}
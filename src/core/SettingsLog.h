@@ -0,0 +1,127 @@
+/**
+ * @file SettingsLog.h
+ * @brief Append-only, wear-levelled record log on the HAL NVS.
+ *
+ * @details
+ * Settings are stored as small keyed records appended to the active page
+ * instead of rewriting a whole struct. A page is only erased when the
+ * active one fills up: the caller then starts a fresh page, appends a full
+ * snapshot and commits it. Pages are used round-robin, so erases are also
+ * spread across the region, and with two pages they act as A/B slots: the
+ * previous slot is kept intact until the next compaction.
+ *
+ * Page layout:
+ * @code
+ *   +0   PageHeader { magic, generation,                 (written on begin)
+ *                     snapshot_crc, snapshot_len, state } (written on commit)
+ *   +16  Snapshot records ... | appended records ... | erased (0xFF)
+ *
+ *   Record = [key:8][len:8] [payload, padded to even] [crc16]
+ * @endcode
+ *
+ * Ordering comes from the page generation (across pages) and the append
+ * position (within a page); later records for the same key win on replay.
+ * A torn append fails its CRC16 and is skipped. A torn compaction leaves
+ * the new page uncommitted. A committed page whose snapshot fails its
+ * CRC32 is rejected at mount. Either way the newest valid slot is used.
+ *
+ * Writes go through I_MMU_Hardware::WriteNVS and may land over the next
+ * few ticks; the in-RAM view (IsMounted(), FreeBytes()) is updated
+ * immediately. After an NVS failure, Recover() resyncs with what was stored.
+ * Addresses below are byte offsets into the NVS range.
+ *
+ * Keys are defined by the caller; 0xFF is reserved (erased NVS).
+ */
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+#include "I_MMU_Hardware.h"
+
+class SettingsLog {
+public:
+    /// Largest payload accepted by Append()
+    static constexpr uint8_t MAX_PAYLOAD = 64;
+
+    typedef void (*RecordVisitor)(uint8_t key, const uint8_t* data, uint8_t len, void* ctx);
+
+    /**
+     * @param nvs        Storage backend.
+     * @param base       Page-aligned NVS offset of the first page.
+     * @param page_count Number of consecutive NVS pages (>= 2).
+     */
+    SettingsLog(I_MMU_Hardware* nvs, uint32_t base, uint8_t page_count);
+
+    /**
+     * @brief Locate the newest committed page and the end of its log.
+     * @return false if the region holds no committed page (blank or foreign).
+     */
+    bool Mount();
+
+    /// Visit every valid record of the active page, oldest first.
+    void Replay(RecordVisitor visit, void* ctx) const;
+
+    /**
+     * @brief Queue one record (a few half-word programs, no erase).
+     * @return false if the page or the NVS write queue is full; the caller
+     *         should compact with BeginPage()/CommitPage().
+     */
+    bool Append(uint8_t key, const void* data, uint8_t len);
+
+    /// Queue an erase of the next page and its (uncommitted) header.
+    /// Until CommitPage(), Append() targets the new page and IsMounted()
+    /// is false; a failed compaction leaves it so, forcing a retry.
+    bool BeginPage();
+
+    /// Mark the page started by BeginPage() as the active one.
+    bool CommitPage();
+
+    /// Re-read the committed state from NVS after a write failure and
+    /// require a compaction before further appends.
+    void Recover();
+
+    bool IsMounted() const { return _mounted; }
+    uint32_t Generation() const { return _generation; }
+    /// Page receiving appends (0 .. page_count-1); after BeginPage(), the page being erased
+    uint8_t Page() const { return _page; }
+    uint16_t UsedBytes() const { return (uint16_t)(_write_addr - PageAddr(_page)); }
+    uint16_t FreeBytes() const { return (uint16_t)(NVS_PAGE_SIZE - UsedBytes()); }
+
+    /// NVS footprint of a record with the given payload length
+    static constexpr uint16_t RecordSize(uint8_t len) { return (uint16_t)(4 + ((len + 1) & ~1)); }
+
+    /// NVS write bytes taken by BeginPage() + CommitPage() on top of the records
+    static constexpr uint16_t PAGE_OVERHEAD = 16;
+
+    /// Committed pages rejected by the last Mount() (bad snapshot CRC32)
+    uint8_t RejectedPages() const { return _rejected; }
+
+private:
+    struct PageHeader {
+        uint32_t magic;
+        uint32_t generation;
+        uint32_t snapshot_crc;  // CRC32 of the snapshot records
+        uint16_t snapshot_len;  // Bytes of records covered by snapshot_crc
+        uint16_t state;         // Programmed last
+    };
+
+    static constexpr uint32_t PAGE_MAGIC = 0x32474C53;  // "SLG2"
+    static constexpr uint16_t STATE_COMMITTED = 0x0000;
+
+    uint32_t PageAddr(uint8_t page) const;
+    uint32_t ScanEnd(uint32_t page_addr) const;
+    bool PageValid(uint32_t page_addr, const PageHeader& hdr) const;
+
+    I_MMU_Hardware* _nvs;
+    uint32_t _base;
+    uint8_t _page_count;
+    uint8_t _page;          // Page receiving appends (active, or pending while compacting)
+    int8_t _active;         // Last committed page, -1 if none
+    uint32_t _generation;   // Generation of _page
+    uint32_t _write_addr;
+    uint32_t _snapshot_crc; // Running CRC32 while compacting
+    bool _mounted;
+    bool _pending;
+    uint8_t _rejected;
+};
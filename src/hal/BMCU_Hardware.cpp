@@ -1,6 +1,7 @@
 #include "BMCU_Hardware.h"
 #include "Hardware.h"
 #include "AS5600.h"
+#include "CrashLog.h"
 
 // External reference to AS5600 object in ControlLogic? 
 // Or should we move AS5600 instance here?
@@ -16,16 +17,59 @@ static AS5600_soft_IIC HAL_AS5600;
 static uint32_t HAL_AS5600_SCL[] = {PB15, PB14, PB13, PB12};
 static uint32_t HAL_AS5600_SDA[] = {PD0, PC15, PC14, PC13};
 
-BMCU_Hardware::BMCU_Hardware() {
+// noinit.ld places this outside .data/.bss, so the startup code neither loads
+// nor zeroes it
+static uint32_t retained_ram[RETAINED_RAM_BYTES / 4] __attribute__((section(".noinit")));
+
+BMCU_Hardware::BMCU_Hardware() : reset_cause(ResetCause::power_on), ready_mask(0),
+    encoders_allocated(false), encoder_probe_start(0), encoder_probe_last(0) {
+}
+
+// Several flags can be set at once (a power-on also sets PINRST), so test
+// the most significant first, then clear them for the next reset.
+static ResetCause ReadResetCause() {
+    ResetCause cause;
+    if (RCC_GetFlagStatus(RCC_FLAG_PORRST)) cause = ResetCause::power_on;
+    else if (RCC_GetFlagStatus(RCC_FLAG_IWDGRST) || RCC_GetFlagStatus(RCC_FLAG_WWDGRST)) cause = ResetCause::watchdog;
+    else if (RCC_GetFlagStatus(RCC_FLAG_SFTRST)) cause = ResetCause::software;
+    else if (RCC_GetFlagStatus(RCC_FLAG_LPWRRST)) cause = ResetCause::low_power;
+    else if (RCC_GetFlagStatus(RCC_FLAG_PINRST)) cause = ResetCause::pin;
+    else cause = ResetCause::power_on;
+    RCC_ClearFlag();
+    return cause;
 }
 
 void BMCU_Hardware::Init() {
-    Hardware::InitBase();
-    Hardware::ADC_Init();
-    Hardware::PWM_Init();
+    reset_cause = ReadResetCause();
+    CrashLog::Init(reset_cause);
+
+    // InitBase() without its blocking ADC fill and LED sequence: the ADC
+    // fills in the background and the encoders are probed from Service(),
+    // so the host can be answered within milliseconds of reset.
+    Hardware::Watchdog_Disable();
+    Hardware::System_Init();
     Hardware::LED_Init();
+    Hardware::PWM_Init();
+    Hardware::ADC_Start();
+    ready_mask = 0;
+    CrashLog::Trace(TraceEvent::boot, (uint8_t)reset_cause, 0);
     
-    HAL_AS5600.init(HAL_AS5600_SCL, HAL_AS5600_SDA, 4);
+    // A stalled loop now resets the unit and leaves its trace for the next boot.
+    // Paths audited against the 2 s period:
+    //  - MMU_Logic::Run() kicks every tick, including HAL bring-up ticks.
+    //  - SaveSettings()/CompactSettings() only queue FlashWriter work; erases
+    //    run one per tick and programming is HALFWORDS_PER_TICK per tick.
+    //  - The only flash wait is the FlashWriter half-word BSY spin, which is
+    //    bounded by FLASH_PROGRAM_SPIN and reloads the IWDG.
+    //  - LoadSettings(), including the legacy-page fallback, reads
+    //    memory-mapped flash only.
+    //  - CLI handlers are bounded: replies are at most one JSON_LIMIT frame
+    //    and UART TX waits are timed out.
+    IWDG_WriteAccessCmd(IWDG_WriteAccess_Enable);
+    IWDG_SetPrescaler(IWDG_Prescaler_64);
+    IWDG_SetReload((uint16_t)(WATCHDOG_TIMEOUT_MS * 5 / 8));
+    IWDG_ReloadCounter();
+    IWDG_Enable();
 }
 
 uint64_t BMCU_Hardware::GetTimeMS() {
@@ -37,7 +81,53 @@ void BMCU_Hardware::DelayMS(uint32_t ms) {
 }
 
 void BMCU_Hardware::WatchdogReset() {
-    // Hardware::Watchdog_Reset(); // If implemented
+    IWDG_ReloadCounter();
+}
+
+void BMCU_Hardware::Service() {
+    flash_writer.Service();
+    
+    if (!(ready_mask & HW_READY_ADC) && Hardware::ADC_Ready()) ready_mask |= HW_READY_ADC;
+    if (!(ready_mask & HW_READY_ENCODERS)) ProbeEncoders();
+}
+
+// init() allocates the driver and probes every sensor once. Lanes that did
+// not answer are re-probed until ENCODER_PROBE_TIMEOUT_MS; only then is the
+// subsystem reported ready, with any stragglers left offline.
+void BMCU_Hardware::ProbeEncoders() {
+    uint64_t now = Hardware::GetTime();
+    if (!encoders_allocated) {
+        HAL_AS5600.init(HAL_AS5600_SCL, HAL_AS5600_SDA, 4);
+        encoders_allocated = true;
+        encoder_probe_start = now;
+        encoder_probe_last = now;
+    } else if (now - encoder_probe_last >= ENCODER_PROBE_INTERVAL_MS) {
+        HAL_AS5600.updata_stu();
+        encoder_probe_last = now;
+    }
+    
+    bool all_online = true;
+    for (int i = 0; i < 4; i++) all_online = all_online && HAL_AS5600.online[i];
+    if (all_online || now - encoder_probe_start >= ENCODER_PROBE_TIMEOUT_MS) {
+        ready_mask |= HW_READY_ENCODERS;
+    }
+}
+
+void* BMCU_Hardware::GetRetainedRAM(uint16_t& len) {
+    len = sizeof(retained_ram);
+    return retained_ram;
+}
+
+void BMCU_Hardware::Trace(TraceEvent event, uint8_t arg, uint16_t value) {
+    CrashLog::Trace(event, arg, value);
+}
+
+const CrashReport* BMCU_Hardware::GetCrashReport() {
+    return CrashLog::Report();
+}
+
+void BMCU_Hardware::ClearCrashReport() {
+    CrashLog::Clear();
 }
 
 void BMCU_Hardware::SetMotorPower(int lane, int pwm_val) {
@@ -82,6 +172,7 @@ bool BMCU_Hardware::GetFilamentPresence(int lane) {
 }
 
 int32_t BMCU_Hardware::GetEncoderValue(int lane) {
+    if (!encoders_allocated) return 0;
     HAL_AS5600.updata_angle(); // This updates ALL. Maybe inefficient to do per lane call?
     // But Interface implies per-lane query.
     // We could optimize by having an Update() method in HAL called by loop.
@@ -97,3 +188,43 @@ void BMCU_Hardware::SetLED(int lane, uint8_t r, uint8_t g, uint8_t b) {
     Hardware::LED_SetColor(lane, 0, r, g, b);
     Hardware::LED_Show();
 }
+
+// --- Persistent Storage ---
+// Flash is memory-mapped, so reads are plain copies. Writes and erases are
+// queued on the FlashWriter and advanced by Service().
+
+static bool NVS_InRange(uint32_t offset, uint32_t len) {
+    return offset <= NVS_FLASH_SIZE && len <= NVS_FLASH_SIZE - offset;
+}
+
+bool BMCU_Hardware::ReadNVS(uint8_t* data, uint16_t len, uint32_t offset) {
+    if (!NVS_InRange(offset, len)) return false;
+    memcpy(data, (const void*)(NVS_FLASH_BASE + offset), len);
+    return true;
+}
+
+bool BMCU_Hardware::WriteNVS(const uint8_t* data, uint16_t len, uint32_t offset) {
+    if (!NVS_InRange(offset, len)) return false;
+    return flash_writer.Program(NVS_FLASH_BASE + offset, data, len);
+}
+
+bool BMCU_Hardware::EraseNVS(uint32_t offset) {
+    if ((offset % NVS_PAGE_SIZE) != 0 || !NVS_InRange(offset, NVS_PAGE_SIZE)) return false;
+    return flash_writer.Erase(NVS_FLASH_BASE + offset);
+}
+
+bool BMCU_Hardware::IsNVSBusy() {
+    return flash_writer.Busy();
+}
+
+bool BMCU_Hardware::TakeNVSError() {
+    return flash_writer.TakeError();
+}
+
+void BMCU_Hardware::GetNVSStats(NVSStats& out) {
+    out = flash_writer.Stats();
+}
+
+void BMCU_Hardware::ResetNVSStats() {
+    flash_writer.ResetStats();
+}
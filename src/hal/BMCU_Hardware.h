@@ -1,6 +1,24 @@
 #pragma once
 
 #include "I_MMU_Hardware.h"
+#include "FlashWriter.h"
+
+// NVS window: the last five 4KB pages of the 64KB Flash (0x0800B000-0x0800FFFF).
+// platformio.ini caps the image at 45056 bytes so code can never overlap it.
+#define NVS_FLASH_BASE 0x0800B000
+#define NVS_FLASH_SIZE (5 * NVS_PAGE_SIZE)
+
+// Size of the .noinit block handed out by GetRetainedRAM()
+#define RETAINED_RAM_BYTES 256
+
+// Encoders that do not answer the probe by then are left offline (they read
+// 0, i.e. no movement) so one dead sensor cannot hold the other lanes off.
+#define ENCODER_PROBE_TIMEOUT_MS 1000
+#define ENCODER_PROBE_INTERVAL_MS 50
+
+// IWDG period; the control loop must call WatchdogReset() within it.
+// LSI (~40 kHz) / 64 gives 0.625 ticks per ms.
+#define WATCHDOG_TIMEOUT_MS 2000
 
 class BMCU_Hardware : public I_MMU_Hardware {
 public:
@@ -12,6 +30,13 @@ public:
     uint64_t GetTimeMS() override;
     void DelayMS(uint32_t ms) override;
     void WatchdogReset() override;
+    void Service() override;
+    uint8_t GetReadyMask() override { return ready_mask; }
+    ResetCause GetResetCause() override { return reset_cause; }
+    void* GetRetainedRAM(uint16_t& len) override;
+    void Trace(TraceEvent event, uint8_t arg, uint16_t value) override;
+    const CrashReport* GetCrashReport() override;
+    void ClearCrashReport() override;
 
     // --- Motors ---
     void SetMotorPower(int lane, int pwm_val) override;
@@ -23,4 +48,23 @@ public:
 
     // --- User Feedback ---
     void SetLED(int lane, uint8_t r, uint8_t g, uint8_t b) override;
+
+    // --- Persistent Storage ---
+    bool ReadNVS(uint8_t* data, uint16_t len, uint32_t offset) override;
+    bool WriteNVS(const uint8_t* data, uint16_t len, uint32_t offset) override;
+    bool EraseNVS(uint32_t offset) override;
+    bool IsNVSBusy() override;
+    bool TakeNVSError() override;
+    void GetNVSStats(NVSStats& out) override;
+    void ResetNVSStats() override;
+
+private:
+    void ProbeEncoders();
+
+    FlashWriter flash_writer;
+    ResetCause reset_cause;
+    uint8_t ready_mask;
+    bool encoders_allocated;
+    uint64_t encoder_probe_start;
+    uint64_t encoder_probe_last;
 };
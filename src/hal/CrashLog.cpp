@@ -0,0 +1,81 @@
+/**
+ * @file CrashLog.cpp
+ * @brief Crash trace ring and trap handler (see CrashLog.h).
+ */
+#include "CrashLog.h"
+#include "Hardware.h"
+
+#define CRASH_LIVE_MAGIC   0x45564C43  // "CLVE"
+#define CRASH_REPORT_MAGIC 0x50524C43  // "CLRP"
+
+// Neither block is touched by the startup code or the heap: noinit.ld puts
+// .noinit between .data and .bss, and links these two first so a crash
+// report keeps its address when other retained blocks change size.
+static CrashReport live __attribute__((section(".noinit.crashlog")));
+static CrashReport report __attribute__((section(".noinit.crashlog")));
+
+namespace CrashLog {
+
+    void Init(ResetCause cause) {
+        if (cause == ResetCause::power_on) {
+            report.magic = 0;
+            report.resets = 0;
+        } else if (live.magic == CRASH_LIVE_MAGIC &&
+                   live.trace_count <= TRACE_DEPTH && live.trace_head < TRACE_DEPTH) {
+            // Keep the count of unread resets across overwrites
+            uint16_t resets = (report.magic == CRASH_REPORT_MAGIC) ? report.resets : 0;
+            report = live;
+            report.magic = CRASH_REPORT_MAGIC;
+            report.reset_cause = (uint8_t)cause;
+            report.resets = (uint16_t)(resets < 0xFFFF ? resets + 1 : resets);
+            if (!report.fault && report.trace_count) {
+                uint8_t last = (uint8_t)((report.trace_head + TRACE_DEPTH - 1) % TRACE_DEPTH);
+                report.time_ms = report.trace[last].time_ms;
+            }
+        }
+
+        memset(&live, 0, sizeof(live));
+        live.magic = CRASH_LIVE_MAGIC;
+    }
+
+    void Trace(TraceEvent event, uint8_t arg, uint16_t value) {
+        TraceEntry &e = live.trace[live.trace_head];
+        e.time_ms = (uint32_t)Hardware::GetTime();
+        e.event = (uint8_t)event;
+        e.arg = arg;
+        e.value = value;
+        live.trace_head = (uint8_t)((live.trace_head + 1) % TRACE_DEPTH);
+        if (live.trace_count < TRACE_DEPTH) live.trace_count++;
+    }
+
+    const CrashReport* Report() {
+        return report.magic == CRASH_REPORT_MAGIC ? &report : nullptr;
+    }
+
+    void Clear() {
+        report.magic = 0;
+        report.resets = 0;
+    }
+}
+
+#if defined(__riscv)
+// Every synchronous exception (illegal instruction, misaligned or faulting
+// access, ...) lands here. Record where, then reset so the unit recovers
+// and the next boot reports it.
+extern "C" __attribute__((interrupt, used)) void HardFault_Handler(void) {
+    uint32_t mcause, mepc, mtval, sp;
+    __asm volatile("csrr %0, mcause" : "=r"(mcause));
+    __asm volatile("csrr %0, mepc" : "=r"(mepc));
+    __asm volatile("csrr %0, mtval" : "=r"(mtval));
+    __asm volatile("mv %0, sp" : "=r"(sp));
+
+    live.fault = 1;
+    live.mcause = mcause;
+    live.mepc = mepc;
+    live.mtval = mtval;
+    live.sp = sp;
+    live.time_ms = (uint32_t)Hardware::GetTime();
+    NVIC_SystemReset();
+    while (1) {}
+}
+#endif
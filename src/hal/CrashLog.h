@@ -0,0 +1,25 @@
+/**
+ * @file CrashLog.h
+ * @brief Event trace and trap capture in reset-surviving RAM.
+ *
+ * @details
+ * Trace() appends to a ring in .noinit RAM. The RISC-V trap handler saves
+ * mcause/mepc/mtval/sp into the same block and resets the MCU. On the next
+ * boot Init() freezes the block into the post-mortem report unless the
+ * reset was a power-on (RAM undefined), then starts a fresh trace.
+ *
+ * Trace() runs from the main loop only; it is not interrupt safe.
+ */
+#pragma once
+
+#include <Arduino.h>
+#include "I_MMU_Hardware.h"
+
+namespace CrashLog {
+    void Init(ResetCause cause);
+    void Trace(TraceEvent event, uint8_t arg, uint16_t value);
+
+    /// Report from the previous run, nullptr if none (or cleared).
+    const CrashReport* Report();
+    void Clear();
+}
@@ -0,0 +1,159 @@
+/**
+ * @file FlashWriter.cpp
+ * @brief Register-level Flash state machine (see FlashWriter.h).
+ */
+#include "FlashWriter.h"
+#include "ch32v20x_flash.h"
+
+#define FLASH_STATR_ERRORS (FLASH_STATR_PGERR | FLASH_STATR_WRPRTERR)
+#define FLASH_PROGRAM_SPIN 20000   ///< BSY polls per half-word before giving up
+
+FlashWriter::FlashWriter()
+    : op_count(0), op_index(0), op_done(0), erasing(false), error(false), data_used(0),
+      batch_start_us(0) {
+    ResetStats();
+}
+
+void FlashWriter::ResetStats() {
+    memset(&stats, 0, sizeof(stats));
+    stats.batch_us_min = 0xFFFFFFFF;
+}
+
+bool FlashWriter::Erase(uint32_t page_addr) {
+    if (op_count >= MAX_OPS) return false;
+    if (op_count == 0) batch_start_us = micros();
+    Op &op = ops[op_count++];
+    op.type = OpType::erase;
+    op.addr = page_addr;
+    op.offset = 0;
+    op.len = 0;
+    return true;
+}
+
+bool FlashWriter::Program(uint32_t addr, const void* src, uint16_t len) {
+    if ((len & 1) || (addr & 1)) return false;
+    if (len > FreeBytes()) return false;
+
+    // Extend the previous program if it ends where this one starts
+    Op* last = op_count > op_index ? &ops[op_count - 1] : nullptr;
+    bool merge = last && last->type == OpType::program &&
+                 last->addr + last->len == addr &&
+                 last->offset + last->len == data_used;
+    if (!merge) {
+        if (op_count >= MAX_OPS) return false;
+        if (op_count == 0) batch_start_us = micros();
+        last = &ops[op_count++];
+        last->type = OpType::program;
+        last->addr = addr;
+        last->offset = data_used;
+        last->len = 0;
+    }
+    memcpy(data + data_used, src, len);
+    data_used += len;
+    last->len += len;
+    return true;
+}
+
+bool FlashWriter::TakeError() {
+    bool e = error;
+    error = false;
+    return e;
+}
+
+// Repeated key writes while unlocked are not allowed, so check first
+void FlashWriter::Unlock() {
+    if (FLASH->CTLR & FLASH_CTLR_LOCK) FLASH_Unlock();
+}
+
+// Reads and clears the sticky error flags of the last operation
+bool FlashWriter::CheckStatus() {
+    uint32_t statr = FLASH->STATR;
+    FLASH->STATR = FLASH_STATR_EOP | FLASH_STATR_ERRORS;
+    return (statr & FLASH_STATR_ERRORS) == 0;
+}
+
+void FlashWriter::Fail() {
+    FLASH->CTLR &= ~(FLASH_CTLR_PER | FLASH_CTLR_PG);
+    error = true;
+    stats.errors++;
+    Finish();
+}
+
+void FlashWriter::Finish() {
+    FLASH_Lock();
+    op_count = 0;
+    op_index = 0;
+    op_done = 0;
+    data_used = 0;
+    erasing = false;
+}
+
+void FlashWriter::Service() {
+    if (op_count == 0) return;
+    if (FLASH->STATR & FLASH_STATR_BSY) return;   // Erase still running
+
+    uint32_t batches = stats.batches;
+    uint32_t start = micros();
+    Step();
+    uint32_t now = micros();
+    if (now - start > stats.stall_us_max) stats.stall_us_max = now - start;
+
+    if (stats.batches != batches) {     // Queue drained without error
+        uint32_t us = now - batch_start_us;
+        if (us < stats.batch_us_min) stats.batch_us_min = us;
+        if (us > stats.batch_us_max) stats.batch_us_max = us;
+        stats.batch_us_total += us;
+    }
+}
+
+// One Service() worth of work: finish a running erase, then start the next
+// erase or program up to HALFWORDS_PER_TICK half-words.
+void FlashWriter::Step() {
+    if (erasing) {
+        FLASH->CTLR &= ~FLASH_CTLR_PER;
+        erasing = false;
+        if (!CheckStatus()) { Fail(); return; }
+        stats.erases++;
+        op_index++;
+    }
+
+    uint8_t budget = HALFWORDS_PER_TICK;
+    while (op_index < op_count) {
+        Op &op = ops[op_index];
+        if (op.type == OpType::erase) {
+            if (budget != HALFWORDS_PER_TICK) return;  // Start erases on a fresh tick
+            Unlock();
+            CheckStatus();
+            FLASH->CTLR |= FLASH_CTLR_PER;
+            FLASH->ADDR = op.addr;
+            FLASH->CTLR |= FLASH_CTLR_STRT;
+            erasing = true;
+            return;
+        }
+
+        Unlock();
+        while (op_done < op.len) {
+            if (budget == 0) return;
+            budget--;
+            uint16_t hw;
+            memcpy(&hw, data + op.offset + op_done, 2);
+            FLASH->CTLR |= FLASH_CTLR_PG;
+            *(volatile uint16_t*)(op.addr + op_done) = hw;
+            uint32_t spin = FLASH_PROGRAM_SPIN;
+            while ((FLASH->STATR & FLASH_STATR_BSY) && --spin) {
+                IWDG->CTLR = 0xAAAA; // Reload IWDG while the half-word programs
+            }
+            FLASH->CTLR &= ~FLASH_CTLR_PG;
+            if (spin == 0 || !CheckStatus() || *(volatile uint16_t*)(op.addr + op_done) != hw) {
+                Fail();
+                return;
+            }
+            op_done += 2;
+            stats.bytes_written += 2;
+        }
+        op_done = 0;
+        op_index++;
+    }
+    stats.batches++;
+    Finish();
+}
@@ -0,0 +1,79 @@
+/**
+ * @file FlashWriter.h
+ * @brief Non-blocking Flash erase/program queue for CH32V203.
+ *
+ * @details
+ * Callers queue page erases and half-word programs; Service() is polled
+ * once per control tick and advances the queue without ever waiting for a
+ * page erase. An erase is started and left running; later ticks poll BSY.
+ * Programming is limited to HALFWORDS_PER_TICK half-words per call, each
+ * a short (~tens of microseconds) wait.
+ *
+ * Queued data is copied, so callers may reuse their buffers immediately.
+ * If any operation fails the remaining queue is dropped and TakeError()
+ * reports it once; clients must then resync from Flash.
+ */
+#pragma once
+
+#include <Arduino.h>
+#include "I_MMU_Hardware.h"
+
+class FlashWriter {
+public:
+    static constexpr uint16_t BUFFER_BYTES = 320;   ///< Pending program data
+    static constexpr uint8_t MAX_OPS = 8;
+    static constexpr uint8_t HALFWORDS_PER_TICK = 16;
+
+    static_assert(BUFFER_BYTES >= NVS_WRITE_QUEUE_MIN && MAX_OPS >= NVS_WRITE_OPS_MIN,
+                  "FlashWriter queue smaller than the NVS contract");
+
+    FlashWriter();
+
+    /// Queue a 4KB page erase. @return false if the queue is full.
+    bool Erase(uint32_t page_addr);
+
+    /// Queue a program of @p len bytes (even, half-word aligned address).
+    /// Contiguous programs are merged. @return false if the queue is full.
+    bool Program(uint32_t addr, const void* data, uint16_t len);
+
+    /// Advance the queue; call once per tick.
+    void Service();
+
+    bool Busy() const { return op_count != 0; }
+    uint16_t FreeBytes() const { return (uint16_t)(BUFFER_BYTES - data_used); }
+
+    /// True once after a failed operation (the queue has been dropped).
+    bool TakeError();
+
+    const NVSStats& Stats() const { return stats; }
+    void ResetStats();
+
+private:
+    enum class OpType : uint8_t { erase, program };
+
+    struct Op {
+        OpType type;
+        uint32_t addr;
+        uint16_t offset;    // Into data[] (program only)
+        uint16_t len;       // Bytes (program only)
+    };
+
+    void Step();
+    void Unlock();
+    bool CheckStatus();
+    void Fail();
+    void Finish();
+
+    Op ops[MAX_OPS];
+    uint8_t op_count;
+    uint8_t op_index;
+    uint16_t op_done;       // Bytes programmed of the current op
+    bool erasing;
+    bool error;
+
+    uint16_t data_used;
+    uint8_t data[BUFFER_BYTES];
+
+    NVSStats stats;
+    uint32_t batch_start_us;
+};
@@ -42,6 +42,7 @@ DMA_InitTypeDef Bambubus_DMA_InitStructure;
 /* DEVELOPMENT STATE: FUNCTIONAL - DO NOT MODIFY */
 namespace Hardware {
     static volatile bool uart_tx_busy = false; // Tracks full TX lifecycle (including DE pin)
+    static volatile UART_ErrorCounters uart_errors = {0, 0, 0, 0};
 
     /* DEVELOPMENT STATE: FUNCTIONAL */
     /**
@@ -219,6 +220,10 @@ namespace Hardware {
         // Note: Reading SR then DR clears ORE, NE, FE, PE
         if ((sr & USART_FLAG_RXNE) || (sr & USART_FLAG_ORE)) 
         {
+            if (sr & USART_FLAG_ORE) uart_errors.overrun++;
+            if (sr & USART_FLAG_FE) uart_errors.framing++;
+            if (sr & USART_FLAG_NE) uart_errors.noise++;
+            if (sr & USART_FLAG_PE) uart_errors.parity++;
             dr = USART1->DATAR; // Read Data Register to clear flags
             // Only convert to byte and callback if it was a valid RXNE
             // (ORE might set RXNE too, or just ORE)
@@ -335,15 +340,46 @@ namespace Hardware {
         return false;
     }
 
+    /**
+     * @brief Copy the UART line error counters.
+     * @param out Destination for a snapshot of the counters.
+     */
+    void UART_GetErrors(UART_ErrorCounters* out) {
+        out->overrun = uart_errors.overrun;
+        out->framing = uart_errors.framing;
+        out->noise = uart_errors.noise;
+        out->parity = uart_errors.parity;
+    }
+
+    /**
+     * @brief Zero the UART line error counters.
+     */
+    void UART_ResetErrors() {
+        uart_errors.overrun = 0;
+        uart_errors.framing = 0;
+        uart_errors.noise = 0;
+        uart_errors.parity = 0;
+    }
+
     // --- ADC ---
     /* DEVELOPMENT STATE: FUNCTIONAL */
     /**
      * @brief Initialize the Analog-to-Digital Converter.
      * 
      * Configures GPIO (PA0-PA7), DMA1 Channel 1 (Circular Buffer), and ADC1.
-     * Runs calibration and starts continuous conversion via DMA.
+     * Runs calibration and starts continuous conversion via DMA, then waits
+     * for the filter buffer to fill.
      */
     void ADC_Init() {
+        ADC_Start();
+        DelayMS(256); // Wait for buffer fill (ADC_filter_n = 256)
+    }
+
+    /* DEVELOPMENT STATE: TESTING */
+    /**
+     * @brief ADC_Init() without the wait; poll ADC_Ready() before use.
+     */
+    void ADC_Start() {
         // GPIO
         {
             RCC_APB2PeriphClockCmd(RCC_APB2Periph_GPIOA, ENABLE);
@@ -398,10 +434,21 @@ namespace Hardware {
             ADC_Calibrattion_Val = Get_CalibrationValue(ADC1);
             for (int i = 0; i < 8; i++)
                 ADC_RegularChannelConfig(ADC1, i, i + 1, ADC_SampleTime_239Cycles5);
+            DMA_ClearFlag(DMA1_FLAG_TC1);
             ADC_DMACmd(ADC1, ENABLE);
             ADC_SoftwareStartConvCmd(ADC1, ENABLE);
         }
-        DelayMS(256); // Wait for buffer fill (ADC_filter_n = 256)
+    }
+
+    /* DEVELOPMENT STATE: TESTING */
+    /**
+     * @brief True once the DMA has filled the whole filter buffer.
+     * 
+     * Transfer-complete is latched on the first wrap of the circular
+     * buffer (no DMA interrupt clears it).
+     */
+    bool ADC_Ready() {
+        return DMA_GetFlagStatus(DMA1_FLAG_TC1) != RESET;
     }
 
     /* DEVELOPMENT STATE: FUNCTIONAL */
@@ -60,8 +60,20 @@ namespace Hardware {
     void UART_SendByte(uint8_t data);
     bool UART_IsBusy();
 
+    // Line error counters, incremented in USART1_IRQHandler
+    struct UART_ErrorCounters {
+        uint32_t overrun;   // ORE: byte lost, MCU did not read DATAR in time
+        uint32_t framing;   // FE: bad stop bit (baud mismatch, line break)
+        uint32_t noise;     // NE: noise detected on RX sampling
+        uint32_t parity;    // PE: parity mismatch (BambuBus mode only)
+    };
+    void UART_GetErrors(UART_ErrorCounters* out);
+    void UART_ResetErrors();
+
     // ADC
     void ADC_Init();
+    void ADC_Start();       // Non-blocking ADC_Init()
+    bool ADC_Ready();       // Filter buffer filled since ADC_Start()
     float* ADC_GetValues(); // Returns pointer to 8 floats
 
     // PWM / Motor
@@ -30,6 +30,13 @@ uint16_t UART_Transport::Available() {
     }
 }
 
+uint16_t UART_Transport::RxFree() {
+    // One slot is always kept empty to tell full from empty, and
+    // RX_END_RESERVE more are held back for line terminators
+    uint16_t room = RX_BUFFER_SIZE - 1 - Available();
+    return room > RX_END_RESERVE ? room - RX_END_RESERVE : 0;
+}
+
 int UART_Transport::Read() {
     if (rx_head == rx_tail) {
         return -1; // No data
@@ -50,6 +57,7 @@ uint16_t UART_Transport::ReadBytes(uint8_t* buffer, uint16_t len) {
 
 uint16_t UART_Transport::Write(const uint8_t* data, uint16_t len) {
     Hardware::UART_Send(data, len);
+    tx_bytes += len;
     return len;
 }
 
@@ -66,11 +74,94 @@ bool UART_Transport::IsBusy() {
     return Hardware::UART_IsBusy();
 }
 
-void UART_Transport::OnByteReceived(uint8_t byte) {
+void UART_Transport::GetStats(TransportStats& out) {
+    Hardware::UART_ErrorCounters err;
+    Hardware::UART_GetErrors(&err);
+    out.rx_bytes = rx_bytes;
+    out.tx_bytes = tx_bytes;
+    out.rx_dropped = rx_dropped;
+    out.overrun = err.overrun;
+    out.framing = err.framing;
+    out.noise = err.noise;
+    out.parity = err.parity;
+}
+
+void UART_Transport::ResetStats() {
+    rx_bytes = 0;
+    tx_bytes = 0;
+    rx_dropped = 0;
+    Hardware::UART_ResetErrors();
+}
+
+bool UART_Transport::PopLineTimestamp(uint32_t* us) {
+    // The caller has just read the terminator, so it sits at rx_tail - 1
+    uint16_t last_read = (rx_tail + RX_BUFFER_SIZE - 1) % RX_BUFFER_SIZE;
+    uint16_t unread = Available();
+    while (line_ts_head != line_ts_tail) {
+        uint16_t pos = line_ts_pos[line_ts_tail];
+        if (pos == last_read) {
+            *us = line_ts[line_ts_tail];
+            line_ts_tail = (line_ts_tail + 1) % LINE_TS_SIZE;
+            return true;
+        }
+        // Terminator not yet read: leave it for a later call
+        if ((uint16_t)((pos + RX_BUFFER_SIZE - rx_tail) % RX_BUFFER_SIZE) < unread) return false;
+        // Already consumed without a pop (line discarded): drop it
+        line_ts_tail = (line_ts_tail + 1) % LINE_TS_SIZE;
+    }
+    return false;
+}
+
+bool UART_Transport::PushByte(uint8_t byte) {
     uint16_t next_head = (rx_head + 1) % RX_BUFFER_SIZE;
-    if (next_head != rx_tail) {
-        rx_buffer[rx_head] = byte;
-        rx_head = next_head;
+    if (next_head == rx_tail) return false;
+    rx_buffer[rx_head] = byte;
+    rx_head = next_head;
+    return true;
+}
+
+void UART_Transport::OnByteReceived(uint8_t byte) {
+    rx_bytes++;
+    bool is_line_end = (byte == '\r' || (byte == '\n' && !last_rx_was_cr));
+    last_rx_was_cr = (byte == '\r');
+    
+    if (!is_line_end) {
+        if (RxFree() == 0 || !PushByte(byte)) {
+            // Buffer full: drop byte and remember the line is incomplete
+            // (the LF of a CRLF pair carries no payload)
+            rx_dropped++;
+            if (byte != '\n') rx_line_damaged = true;
+        }
+        return;
+    }
+    
+    // A damaged line needs room for the marker and the terminator. The
+    // reserve guarantees it once the line stored a byte; a line that lost
+    // every byte is dropped whole here (no id to reply to, so the host
+    // times it out) and the damage carries over to the next line.
+    if (rx_line_damaged && RX_BUFFER_SIZE - 1 - Available() < 2) {
+        rx_dropped++;
+        return;
+    }
+    
+    if (rx_line_damaged) {
+        PushByte(RX_OVERRUN_MARKER);
+        rx_line_damaged = false;
+    }
+    
+    uint16_t term_pos = rx_head;
+    if (!PushByte(byte)) {
+        rx_dropped++;
+        rx_line_damaged = true;
+        return;
+    }
+    
+    // Stamp each line end once (CR, LF, or the CR of a CRLF pair),
+    // matching the terminator handling in KlipperCLI::Run
+    uint8_t next_ts = (line_ts_head + 1) % LINE_TS_SIZE;
+    if (next_ts != line_ts_tail) {
+        line_ts[line_ts_head] = micros();
+        line_ts_pos[line_ts_head] = term_pos;
+        line_ts_head = next_ts;
     }
-    // If buffer full, drop byte
 }
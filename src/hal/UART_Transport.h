@@ -25,6 +25,11 @@ public:
     
     bool IsConnected() override;
     bool IsBusy() override;
+    
+    uint16_t RxFree() override;
+    void GetStats(TransportStats& out) override;
+    void ResetStats() override;
+    bool PopLineTimestamp(uint32_t* us) override;
 
     // Internal: Called by RX interrupt to buffer incoming bytes
     void OnByteReceived(uint8_t byte);
@@ -33,6 +38,25 @@ private:
     // Ring buffer for received bytes (reverted to 1024 for RAM safety)
     static constexpr uint16_t RX_BUFFER_SIZE = 1024;
     volatile uint8_t rx_buffer[RX_BUFFER_SIZE];
+    // Slots payload bytes may not use, so a line that stored any byte can
+    // always be closed with the overrun marker and its terminator
+    static constexpr uint16_t RX_END_RESERVE = 2;
     volatile uint16_t rx_head = 0;
     volatile uint16_t rx_tail = 0;
+    
+    // Arrival times (micros) of line terminators, tagged with the ring
+    // position of the terminator byte so stale entries can be discarded
+    static constexpr uint8_t LINE_TS_SIZE = 8;
+    volatile uint32_t line_ts[LINE_TS_SIZE];
+    volatile uint16_t line_ts_pos[LINE_TS_SIZE];
+    volatile uint8_t line_ts_head = 0;
+    volatile uint8_t line_ts_tail = 0;
+    volatile bool last_rx_was_cr = false;
+    
+    volatile uint32_t rx_bytes = 0;
+    volatile uint32_t tx_bytes = 0;
+    volatile uint32_t rx_dropped = 0;
+    volatile bool rx_line_damaged = false; // Current line lost bytes
+    
+    bool PushByte(uint8_t byte);
 };
@@ -0,0 +1,11 @@
+# Links noinit.ld next to the board linker script and writes a map file.
+#
+# Runs as a post: script so the board script's -T is already in LINKFLAGS.
+# noinit.ld is prepended in front of it: ld resolves INSERT only against a
+# script that follows, and a -Wl,-T in build_flags would instead make
+# PlatformIO drop the board script. A wrong order fails the link
+# (".bss not found for insert") rather than misplacing the section.
+Import("env")
+
+env.Prepend(LINKFLAGS=["-T", env.subst("$PROJECT_DIR/src/hal/noinit.ld")])
+env.Append(LINKFLAGS=["-Wl,-Map," + env.subst("$BUILD_DIR/firmware.map")])
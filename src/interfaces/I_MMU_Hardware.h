@@ -1,6 +1,88 @@
 #pragma once
 
 #include <stdint.h>
+#include <string.h>
+
+// --- Non-Volatile Storage Contract ---
+// NVS is a flat byte range organised in erase pages. Bytes read back as 0xFF
+// after EraseNVS() and may then be written once. Writes and erases may
+// complete asynchronously (see IsNVSBusy()); an idle implementation must
+// accept at least NVS_WRITE_QUEUE_MIN bytes in up to NVS_WRITE_OPS_MIN
+// separate Write/Erase calls before WriteNVS() returns false.
+#define NVS_PAGE_SIZE 4096
+#define NVS_WRITE_QUEUE_MIN 320
+#define NVS_WRITE_OPS_MIN 8
+
+/// Runtime NVS counters since boot or the last ResetNVSStats()
+struct NVSStats {
+    uint32_t erases;            ///< Page erases completed
+    uint32_t bytes_written;     ///< Bytes programmed
+    uint32_t errors;            ///< Failed erases/writes
+    uint32_t batches;           ///< Busy periods (first queued op to idle)
+    uint32_t batch_us_min;
+    uint32_t batch_us_max;
+    uint32_t batch_us_total;
+    uint32_t stall_us_max;      ///< Longest single Service() call
+};
+
+/// Why the MCU last came out of reset
+enum class ResetCause : uint8_t {
+    power_on,       // Power-on / brown-out: RAM contents are undefined
+    pin,            // NRST pin (debugger, reset button)
+    software,       // NVIC_SystemReset()
+    watchdog,       // IWDG or WWDG
+    low_power,      // Wake-up from standby
+};
+
+// --- Crash Capture ---
+// A small trace of recent events is kept in RAM that survives resets.
+// After any reset other than power-on it is frozen, together with the
+// trap registers if the reset came from an exception, into a CrashReport.
+#define TRACE_DEPTH 24
+
+enum class TraceEvent : uint8_t {
+    none,
+    boot,           // arg = ResetCause
+    command,        // arg = command table index, value = packet id
+    lane_state,     // arg = lane, value = position << 8 | motion
+    save,           // arg = 1 ok / 0 failed, value = log bytes free
+    compact,        // arg = new page, value = generation
+    journal_roll,   // value = new epoch (low 16 bits)
+    nvs_error,
+    host_timeout,   // arg = lanes stopped
+    host_reconnect,
+    warm_restore,   // value = consecutive warm restarts, arg = 1 if motion was not resumed
+};
+
+struct TraceEntry {
+    uint32_t time_ms;
+    uint8_t event;              // TraceEvent
+    uint8_t arg;
+    uint16_t value;
+};
+
+struct CrashReport {
+    uint32_t magic;
+    uint8_t reset_cause;        // ResetCause that froze the report
+    uint8_t fault;              // Non-zero if a trap was taken; registers valid
+    uint16_t resets;            // Non-power-on resets since last cleared
+    uint32_t mcause;
+    uint32_t mepc;
+    uint32_t mtval;
+    uint32_t sp;
+    uint32_t time_ms;           // Uptime of the fault (or last trace entry)
+    uint8_t trace_count;
+    uint8_t trace_head;         // Next slot; oldest entry when full
+    uint16_t reserved;
+    TraceEntry trace[TRACE_DEPTH];
+};
+
+// Subsystems that finish initialising in the background after Init()
+enum : uint8_t {
+    HW_READY_ADC      = 0x01,   // Pressure/presence readings valid
+    HW_READY_ENCODERS = 0x02,   // Encoder probe finished; GetEncoderValue() valid
+    HW_READY_ALL      = 0x03,
+};
 
 /**
  * @brief Abstract Hardware Abstraction Layer for MMU.
@@ -13,10 +95,39 @@ public:
     virtual ~I_MMU_Hardware() {}
 
     // --- System ---
+    /// Must return quickly: slow bring-up continues in Service() and is
+    /// reported through GetReadyMask().
     virtual void Init() = 0;
     virtual uint64_t GetTimeMS() = 0;
     virtual void DelayMS(uint32_t ms) = 0;
     virtual void WatchdogReset() = 0;
+    
+    /// Background work (e.g. pending NVS operations). Called once per control tick.
+    virtual void Service() {}
+    
+    /// HW_READY_* bits of the subsystems that are usable.
+    virtual uint8_t GetReadyMask() { return HW_READY_ALL; }
+    
+    /// Reset cause latched by Init().
+    virtual ResetCause GetResetCause() { return ResetCause::power_on; }
+    
+    /**
+     * @brief RAM that is not cleared by the startup code.
+     * 
+     * Contents survive every reset except power-on and are garbage after
+     * one, so callers must validate what they read (magic, CRC).
+     * 
+     * @param len Receives the size in bytes (0 if unsupported).
+     * @return 4-byte aligned buffer, or nullptr.
+     */
+    virtual void* GetRetainedRAM(uint16_t& len) { len = 0; return nullptr; }
+    
+    /// Record an event in the crash trace (cheap; callable every tick).
+    virtual void Trace(TraceEvent event, uint8_t arg = 0, uint16_t value = 0) {}
+    
+    /// Report frozen at boot from the previous run, or nullptr if none.
+    virtual const CrashReport* GetCrashReport() { return nullptr; }
+    virtual void ClearCrashReport() {}
 
     // --- Motors ---
     /**
@@ -74,6 +185,7 @@ public:
      * @brief Read settings from non-volatile storage.
      * 
      * Optional method - default implementation returns false (no storage).
+     * Returns the stored contents; queued writes are not visible until done.
      * 
      * @param data   Buffer to read into.
      * @param len    Number of bytes to read.
@@ -86,11 +198,34 @@ public:
      * @brief Write settings to non-volatile storage.
      * 
      * Optional method - default implementation returns false (no storage).
+     * The target bytes must be erased. The data is copied, and the write
+     * may complete on later Service() calls.
      * 
      * @param data   Buffer to write.
-     * @param len    Number of bytes to write.
-     * @param offset Address/offset in storage.
-     * @return true  Write successful.
+     * @param len    Number of bytes to write (even).
+     * @param offset Address/offset in storage (even).
+     * @return true  Write accepted.
      */
     virtual bool WriteNVS(const uint8_t* data, uint16_t len, uint32_t offset) { return false; }
+    
+    /**
+     * @brief Erase one NVS_PAGE_SIZE page to 0xFF.
+     * 
+     * Optional method - default implementation returns false (no storage).
+     * Ordered with WriteNVS(): later writes land after the erase.
+     * 
+     * @param offset Page-aligned offset in storage.
+     * @return true  Erase accepted.
+     */
+    virtual bool EraseNVS(uint32_t offset) { return false; }
+    
+    /// True while accepted writes/erases are still in progress.
+    virtual bool IsNVSBusy() { return false; }
+    
+    /// True once after a write or erase failed; pending operations were dropped.
+    virtual bool TakeNVSError() { return false; }
+    
+    /// Endurance and latency counters (default: all zero).
+    virtual void GetNVSStats(NVSStats& out) { memset(&out, 0, sizeof(out)); }
+    virtual void ResetNVSStats() {}
 };
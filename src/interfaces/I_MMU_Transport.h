@@ -1,5 +1,19 @@
 #pragma once
 #include <stdint.h>
+#include <string.h>
+
+/**
+ * @brief Link health counters reported by a transport.
+ */
+struct TransportStats {
+    uint32_t rx_bytes;      ///< Bytes received from the line
+    uint32_t tx_bytes;      ///< Bytes handed to the line
+    uint32_t rx_dropped;    ///< Bytes dropped because the RX buffer was full
+    uint32_t overrun;       ///< Hardware overruns (byte lost before ISR read it)
+    uint32_t framing;       ///< Framing errors
+    uint32_t noise;         ///< Noise errors
+    uint32_t parity;        ///< Parity errors
+};
 
 /**
  * @file I_MMU_Transport.h
@@ -14,6 +28,12 @@ class I_MMU_Transport {
 public:
     virtual ~I_MMU_Transport() {}
 
+    /**
+     * Byte inserted before a line terminator when bytes of that line were
+     * dropped on receive. The protocol layer discards the line and replies BUSY.
+     */
+    static constexpr uint8_t RX_OVERRUN_MARKER = 0x18;
+
     //=========================================================================
     // INITIALIZATION
     //=========================================================================
@@ -61,6 +81,35 @@ public:
      */
     virtual void Flush() = 0;
 
+    /**
+     * @brief Free space in the receive buffer (flow-control credit).
+     * @return Bytes the host may send without risking a drop.
+     */
+    virtual uint16_t RxFree() = 0;
+
+    /**
+     * @brief Read link health counters.
+     * 
+     * Optional - default implementation reports all zeros.
+     */
+    virtual void GetStats(TransportStats& out) { memset(&out, 0, sizeof(out)); }
+
+    /**
+     * @brief Zero the link health counters.
+     */
+    virtual void ResetStats() {}
+
+    /**
+     * @brief Pop the arrival time of the oldest unread line terminator.
+     * 
+     * Optional - lets the protocol layer separate queueing delay from
+     * execution time. Default implementation has no timestamps.
+     * 
+     * @param us Receives the device microsecond clock at terminator arrival.
+     * @return true if a timestamp was available.
+     */
+    virtual bool PopLineTimestamp(uint32_t* us) { return false; }
+
     //=========================================================================
     // CONNECTION STATUS
     //=========================================================================
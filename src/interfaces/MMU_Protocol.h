@@ -83,12 +83,27 @@ namespace CommandStr {
     constexpr const char* GET_SENSORS     = "GET_SENSORS";
     constexpr const char* RESET           = "RESET";
     constexpr const char* MOVE            = "MOVE";
+    constexpr const char* MOVE_POS        = "MOVE_POS";
+    constexpr const char* QUEUE_MOVE      = "QUEUE_MOVE";
+    constexpr const char* GROUP_MOVE      = "GROUP_MOVE";
+    constexpr const char* EXTRUDER_VEL    = "EXTRUDER_VEL";
     constexpr const char* STOP            = "STOP";
     constexpr const char* LOAD            = "LOAD_FILAMENT";
     constexpr const char* UNLOAD          = "UNLOAD_FILAMENT";
     constexpr const char* SELECT_LANE     = "SELECT_LANE";
     constexpr const char* SET_FILAMENT_INFO = "SET_FILAMENT_INFO";
     constexpr const char* GET_FILAMENT_INFO = "GET_FILAMENT_INFO";
+    constexpr const char* TIME_SYNC       = "TIME_SYNC";
+    constexpr const char* COMM_STATS      = "COMM_STATS";
+    constexpr const char* FLASH_STATS     = "FLASH_STATS";
+    constexpr const char* CRASHLOG        = "CRASHLOG";
+    constexpr const char* MOTOR_MODEL     = "MOTOR_MODEL";
+    constexpr const char* AUTOTUNE        = "AUTOTUNE";
+    constexpr const char* CAPTURE         = "CAPTURE";
+    constexpr const char* CAPTURE_READ    = "CAPTURE_READ";
+    constexpr const char* CAPS            = "CAPS";
+    constexpr const char* SET_CONFIG      = "SET_CONFIG";
+    constexpr const char* OBSERVER        = "OBSERVER";
 }
 
 //=============================================================================